@@ -0,0 +1,89 @@
+/**
+ * Compare the file sinks writing the same records from one thread.
+ *
+ * Usage: file_sink_bench [message_count] [directory...]
+ *
+ * Run it on several file systems, e.g. tmpfs and ext4:
+ *
+ *      ./file_sink_bench 1000000 /dev/shm ./logs
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "spdlog_json_config.h"
+
+
+typedef std::function<std::shared_ptr<spdlog::sinks::sink>(const std::string&)> sink_factory;
+
+struct bench_sink {
+    const char*     name;
+    sink_factory    create;
+};
+
+
+static void run_bench(const bench_sink& sink_type, const std::string& directory, size_t message_count){
+    std::string file_name = directory + "/file_sink_bench_" + sink_type.name + ".log";
+    std::shared_ptr<spdlog::sinks::sink> sink = sink_type.create(file_name);
+    spdlog::logger logger("BENCH", sink);
+    logger.set_pattern("[%C-%m-%d %H:%M:%S.%e][%n]%^[%L]%$ %v");
+
+    std::chrono::steady_clock::duration max_latency(0);
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    for(size_t i = 0; i < message_count; i++){
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        logger.info("benchmark message {} with some payload to reach a usual log line length", i);
+        std::chrono::steady_clock::duration latency = std::chrono::steady_clock::now() - start;
+        if(latency > max_latency) max_latency = latency;
+    }
+    logger.flush();
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+    double seconds = std::chrono::duration<double>(end - begin).count();
+    printf("%-24s %-24s %12.0f msg/s %10.1f ns/msg %10ld us max\n",
+           directory.c_str(), sink_type.name, message_count / seconds, seconds * 1e9 / message_count,
+           static_cast<long>(std::chrono::duration_cast<std::chrono::microseconds>(max_latency).count()));
+
+    unlink(file_name.c_str());
+    for(int i = 1; i <= 3; i++){
+        unlink(spdlog::sinks::rotating_file_sink_mt::calc_filename(file_name, i).c_str());
+    }
+}
+
+
+int main(int argc, char* argv[]){
+    size_t message_count = 1000000;
+    std::vector<std::string> directories;
+    if(argc > 1) message_count = strtoul(argv[1], nullptr, 10);
+    for(int i = 2; i < argc; i++) directories.push_back(argv[i]);
+    if(directories.empty()) directories.push_back(".");
+
+    std::vector<bench_sink> sink_types = {
+        {"basic_file_sink_mt", [](const std::string& file_name){
+            return std::make_shared<spdlog::sinks::basic_file_sink_mt>(file_name, true);
+        }},
+        {"rotating_file_sink_mt", [](const std::string& file_name){
+            return std::make_shared<spdlog::sinks::rotating_file_sink_mt>(file_name, 64 * 1024 * 1024, 3);
+        }},
+        {"mmap_file_sink_mt", [](const std::string& file_name){
+            return std::make_shared<spdlog_json_config::sinks::mmap_file_sink_mt>(
+                       file_name, true, 16 * 1024 * 1024, spdlog_json_config::sinks::msync_policy::none);
+        }},
+        {"io_uring_file_sink_mt", [](const std::string& file_name){
+            return std::make_shared<spdlog_json_config::sinks::io_uring_file_sink_mt>(
+                       file_name, true, 8, 256 * 1024);
+        }}
+    };
+
+    for(const std::string& directory : directories){
+        for(const bench_sink& sink_type : sink_types){
+            run_bench(sink_type, directory, message_count);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,457 @@
+#ifndef __SPDLOG_JSON_CONFIG_DEFERRED_ASYNC_LOGGER_H__
+#define __SPDLOG_JSON_CONFIG_DEFERRED_ASYNC_LOGGER_H__
+
+#include <atomic>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <stdint.h>
+#include <string.h>
+
+#include "spdlog/logger.h"
+#include "spdlog/async_logger.h"
+#include "spdlog/details/os.h"
+
+#include "details/deferred_args.h"
+#include "details/record_ring.h"
+#include "details/worker_pool.h"
+
+
+namespace spdlog_json_config {
+
+/**
+ * @brief  Async logger which formats the message on the worker thread (sync_type "async_deferred").
+ *
+ * The producer only copies the format string pointer and the raw arguments in a slot of
+ * a lock free ring: arithmetic, enum, void* and is_deferred_value arguments byte for byte,
+ * strings by value.
+ * The worker formats the message later and writes it to the sinks.
+ *
+ * The deferred path is taken by the methods of this class, i.e. through the pointer
+ * returned by SpdlogJsonConfig::GetDeferredLogger(). Calls through spdlog::logger, and
+ * calls with arguments which cannot be copied raw, are formatted by the producer and
+ * queued in the same ring, so the order of the messages is kept.
+ *
+ * The format string must be a compile-time string, e.g. a string literal: only its pointer is
+ * queued. A runtime format string, fmt::runtime(), is formatted by the producer.
+ *
+ * The logger is also used for the "async" and "async_nb" loggers when the worker pool is
+ * elastic. They are used through spdlog::logger, i.e. format in the caller and queue the payload.
+ */
+class deferred_async_logger : public spdlog::logger, public details::async_lane {
+public:
+    const static size_t SLOT_SIZE = 256;    ///< bytes of a queue slot, i.e. max size of a deferred record
+
+    typedef details::record_ring<SLOT_SIZE> ring_type;
+
+#if FMT_VERSION >= 100000
+    typedef fmt::runtime_format_string<char> runtime_format_string;
+#else
+    typedef fmt::basic_runtime<char> runtime_format_string;
+#endif
+
+    /// @param  policy  block, or overrun_oldest to drop the oldest record when the queue is full
+    template <typename It>
+    deferred_async_logger(std::string logger_name, It begin, It end,
+                          std::weak_ptr<details::worker_pool> pool, size_t queue_size,
+                          spdlog::async_overflow_policy policy = spdlog::async_overflow_policy::block)
+        : spdlog::logger(std::move(logger_name), begin, end),
+          pool_(std::move(pool)), ring_(queue_size), overflow_policy_(policy), overrun_counter_(0) {}
+
+    /// Records left when the worker pool is gone are written here.
+    ~deferred_async_logger() {
+        process(ring_.capacity());
+    }
+
+    using spdlog::logger::log;
+
+    template <typename... Args>
+    void log(spdlog::source_loc loc, spdlog::level::level_enum lvl,
+             spdlog::format_string_t<Args...> fmt, Args&&... args) {
+        LogDeferred(loc, lvl, fmt, std::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    void log(spdlog::level::level_enum lvl, spdlog::format_string_t<Args...> fmt, Args&&... args) {
+        LogDeferred(spdlog::source_loc{}, lvl, fmt, std::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    void trace(spdlog::format_string_t<Args...> fmt, Args&&... args) {
+        LogDeferred(spdlog::source_loc{}, spdlog::level::trace, fmt, std::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    void debug(spdlog::format_string_t<Args...> fmt, Args&&... args) {
+        LogDeferred(spdlog::source_loc{}, spdlog::level::debug, fmt, std::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    void info(spdlog::format_string_t<Args...> fmt, Args&&... args) {
+        LogDeferred(spdlog::source_loc{}, spdlog::level::info, fmt, std::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    void warn(spdlog::format_string_t<Args...> fmt, Args&&... args) {
+        LogDeferred(spdlog::source_loc{}, spdlog::level::warn, fmt, std::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    void error(spdlog::format_string_t<Args...> fmt, Args&&... args) {
+        LogDeferred(spdlog::source_loc{}, spdlog::level::err, fmt, std::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    void critical(spdlog::format_string_t<Args...> fmt, Args&&... args) {
+        LogDeferred(spdlog::source_loc{}, spdlog::level::critical, fmt, std::forward<Args>(args)...);
+    }
+
+    // Runtime format strings, e.g. fmt::runtime(std::string), may not outlive the call:
+    // their messages are formatted by the caller.
+    template <typename... Args>
+    void log(spdlog::source_loc loc, spdlog::level::level_enum lvl, runtime_format_string fmt, Args&&... args) {
+        spdlog::logger::log(loc, lvl, spdlog::format_string_t<Args...>(fmt), std::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    void log(spdlog::level::level_enum lvl, runtime_format_string fmt, Args&&... args) {
+        log(spdlog::source_loc{}, lvl, fmt, std::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    void trace(runtime_format_string fmt, Args&&... args) {
+        log(spdlog::source_loc{}, spdlog::level::trace, fmt, std::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    void debug(runtime_format_string fmt, Args&&... args) {
+        log(spdlog::source_loc{}, spdlog::level::debug, fmt, std::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    void info(runtime_format_string fmt, Args&&... args) {
+        log(spdlog::source_loc{}, spdlog::level::info, fmt, std::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    void warn(runtime_format_string fmt, Args&&... args) {
+        log(spdlog::source_loc{}, spdlog::level::warn, fmt, std::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    void error(runtime_format_string fmt, Args&&... args) {
+        log(spdlog::source_loc{}, spdlog::level::err, fmt, std::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    void critical(runtime_format_string fmt, Args&&... args) {
+        log(spdlog::source_loc{}, spdlog::level::critical, fmt, std::forward<Args>(args)...);
+    }
+
+    // Messages which are not format strings are logged as usual.
+    template <typename T> void trace(const T& msg)    { spdlog::logger::trace(msg); }
+    template <typename T> void debug(const T& msg)    { spdlog::logger::debug(msg); }
+    template <typename T> void info(const T& msg)     { spdlog::logger::info(msg); }
+    template <typename T> void warn(const T& msg)     { spdlog::logger::warn(msg); }
+    template <typename T> void error(const T& msg)    { spdlog::logger::error(msg); }
+    template <typename T> void critical(const T& msg) { spdlog::logger::critical(msg); }
+
+    /// @brief  Format and write up to max_records queued records. Called by the worker pool.
+    size_t process(size_t max_records) override {
+        size_t count = 0;
+        RecordReader reader(this);
+        while(count < max_records && ring_.try_pop(reader)){
+            count++;
+        }
+        return count;
+    }
+
+    bool empty() const override {
+        return ring_.empty();
+    }
+
+    /// @brief  Approximate number of queued records
+    size_t size() const override {
+        return ring_.size();
+    }
+
+    /// @brief  Number of records dropped because the queue was full
+    size_t overrun_counter() const {
+        return overrun_counter_.load(std::memory_order_relaxed);
+    }
+
+protected:
+    /// Messages formatted by the producer: queued as a copy of the payload.
+    void sink_it_(const spdlog::details::log_msg& msg) override {
+        try{
+            PayloadWriter writer(msg);
+            Push(writer);
+        }
+        catch(const std::exception& ex){
+            err_handler_(ex.what());
+        }
+    }
+
+    void flush_() override {
+        if(sinks_.empty()){
+            return;
+        }
+        try{
+            FlushWriter writer;
+            Push(writer);
+        }
+        catch(const std::exception& ex){
+            err_handler_(ex.what());
+        }
+    }
+
+    void backend_sink_it_(const spdlog::details::log_msg& msg) {
+        for(auto& sink : sinks_){
+            if(sink->should_log(msg.level)){
+                try{
+                    sink->log(msg);
+                }
+                catch(const std::exception& ex){
+                    err_handler_(ex.what());
+                }
+            }
+        }
+
+        if(should_flush_(msg)){
+            backend_flush_();
+        }
+    }
+
+    void backend_flush_() {
+        for(auto& sink : sinks_){
+            try{
+                sink->flush();
+            }
+            catch(const std::exception& ex){
+                err_handler_(ex.what());
+            }
+        }
+    }
+
+private:
+    typedef void (*format_fn)(spdlog::string_view_t, const unsigned char*, spdlog::memory_buf_t&);
+
+    enum record_type : uint8_t {
+        RECORD_DEFERRED,        ///< format string and arguments, formatted by the worker
+        RECORD_INLINE_PAYLOAD,  ///< formatted message copied after the record
+        RECORD_HEAP_PAYLOAD,    ///< formatted message too large for the slot
+        RECORD_FLUSH            ///< flush the sinks
+    };
+
+    /// Header of a record in a ring slot. The arguments or the payload follow at DATA_OFFSET.
+    struct record {
+        format_fn                       format;
+        const char*                     fmt_data;
+        size_t                          fmt_size;
+        std::string*                    heap_payload;
+        spdlog::log_clock::time_point   time;
+        spdlog::source_loc              source;
+        size_t                          thread_id;
+        uint32_t                        payload_size;
+        spdlog::level::level_enum       level;
+        record_type                     type;
+    };
+
+    const static size_t DATA_OFFSET = (sizeof(record) + 15) & ~(size_t)15;
+    static_assert(DATA_OFFSET < ring_type::DATA_SIZE, "slot too small for a deferred record");
+
+    static void WritePayload(record* rec, unsigned char* data, spdlog::string_view_t payload) {
+        if(payload.size() <= ring_type::DATA_SIZE - DATA_OFFSET){
+            rec->type = RECORD_INLINE_PAYLOAD;
+            rec->payload_size = (uint32_t)payload.size();
+            if(payload.size() > 0){
+                memcpy(data + DATA_OFFSET, payload.data(), payload.size());
+            }
+        }
+        else {
+            rec->type = RECORD_HEAP_PAYLOAD;
+            rec->heap_payload = new std::string(payload.data(), payload.size());
+        }
+    }
+
+    /// Writes a call whose arguments are copied raw. Formats it at once if they don't fit.
+    template <typename... Args>
+    struct DeferredWriter {
+        typedef details::deferred_args<typename std::decay<Args>::type...> args_type;
+
+        spdlog::source_loc              loc;
+        spdlog::level::level_enum       lvl;
+        spdlog::string_view_t           fmt;
+        std::tuple<const Args&...>      args;
+
+        void operator()(unsigned char* data) {
+            Write(data, details::make_indices<sizeof...(Args)>());
+        }
+
+        template <size_t... Is>
+        void Write(unsigned char* data, details::indices<Is...>) {
+            record* rec = new (data) record();
+            rec->time = spdlog::log_clock::now();
+            rec->source = loc;
+            rec->thread_id = spdlog::details::os::thread_id();
+            rec->level = lvl;
+
+            details::arg_writer w = { data + DATA_OFFSET, data + ring_type::DATA_SIZE, true };
+            if(args_type::encode(w, std::get<Is>(args)...)){
+                rec->type = RECORD_DEFERRED;
+                rec->format = &args_type::format;
+                rec->fmt_data = fmt.data();
+                rec->fmt_size = fmt.size();
+                return;
+            }
+
+            // Arguments too large for the slot: format now
+            try{
+                spdlog::memory_buf_t buf;
+                fmt::vformat_to(fmt::appender(buf), fmt, fmt::make_format_args(std::get<Is>(args)...));
+                WritePayload(rec, data, spdlog::string_view_t(buf.data(), buf.size()));
+            }
+            catch(const std::exception& ex){
+                WritePayload(rec, data, spdlog::string_view_t(ex.what(), strlen(ex.what())));
+            }
+        }
+    };
+
+    struct PayloadWriter {
+        explicit PayloadWriter(const spdlog::details::log_msg& msg) : msg_(msg) {}
+
+        void operator()(unsigned char* data) {
+            record* rec = new (data) record();
+            rec->time = msg_.time;
+            rec->source = msg_.source;
+            rec->thread_id = msg_.thread_id;
+            rec->level = msg_.level;
+            WritePayload(rec, data, msg_.payload);
+        }
+
+        const spdlog::details::log_msg& msg_;
+    };
+
+    struct FlushWriter {
+        void operator()(unsigned char* data) {
+            record* rec = new (data) record();
+            rec->type = RECORD_FLUSH;
+        }
+    };
+
+    /// Drops a record, for the overrun_oldest policy
+    struct RecordDiscarder {
+        void operator()(const unsigned char* data) {
+            const record* rec = reinterpret_cast<const record*>(data);
+            if(rec->type == RECORD_HEAP_PAYLOAD){
+                delete rec->heap_payload;
+            }
+        }
+    };
+
+    struct RecordReader {
+        explicit RecordReader(deferred_async_logger* logger) : logger_(logger) {}
+
+        void operator()(const unsigned char* data) {
+            const record* rec = reinterpret_cast<const record*>(data);
+            if(rec->type == RECORD_FLUSH){
+                logger_->backend_flush_();
+                return;
+            }
+
+            spdlog::memory_buf_t buf;
+            spdlog::string_view_t payload;
+            std::unique_ptr<std::string> heap_payload;
+            if(rec->type == RECORD_DEFERRED){
+                try{
+                    rec->format(spdlog::string_view_t(rec->fmt_data, rec->fmt_size), data + DATA_OFFSET, buf);
+                }
+                catch(const std::exception& ex){
+                    logger_->err_handler_(ex.what());
+                    return;
+                }
+                payload = spdlog::string_view_t(buf.data(), buf.size());
+            }
+            else if(rec->type == RECORD_INLINE_PAYLOAD){
+                payload = spdlog::string_view_t((const char*)data + DATA_OFFSET, rec->payload_size);
+            }
+            else {
+                heap_payload.reset(rec->heap_payload);
+                payload = spdlog::string_view_t(heap_payload->data(), heap_payload->size());
+            }
+
+            spdlog::details::log_msg msg(rec->time, rec->source, logger_->name_, rec->level, payload);
+            msg.thread_id = rec->thread_id;
+            logger_->backend_sink_it_(msg);
+        }
+
+        deferred_async_logger* logger_;
+    };
+
+    template <typename... Args>
+    void LogDeferred(spdlog::source_loc loc, spdlog::level::level_enum lvl,
+                     spdlog::format_string_t<Args...> fmt, Args&&... args) {
+        // backtrace needs the formatted message, let spdlog::logger handle it
+        if(tracer_.enabled()){
+            spdlog::logger::log(loc, lvl, fmt, std::forward<Args>(args)...);
+            return;
+        }
+        if(!should_log(lvl)){
+            return;
+        }
+
+        typedef std::integral_constant<bool,
+            details::deferred_args<typename std::decay<Args>::type...>::deferrable> deferrable;
+        LogDeferred(deferrable(), loc, lvl, fmt, std::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    void LogDeferred(std::true_type, spdlog::source_loc loc, spdlog::level::level_enum lvl,
+                     spdlog::format_string_t<Args...> fmt, Args&&... args) {
+        try{
+            DeferredWriter<Args...> writer = { loc, lvl, fmt, std::tuple<const Args&...>(args...) };
+            Push(writer);
+        }
+        catch(const std::exception& ex){
+            err_handler_(ex.what());
+        }
+    }
+
+    template <typename... Args>
+    void LogDeferred(std::false_type, spdlog::source_loc loc, spdlog::level::level_enum lvl,
+                     spdlog::format_string_t<Args...> fmt, Args&&... args) {
+        spdlog::logger::log(loc, lvl, fmt, std::forward<Args>(args)...);
+    }
+
+    /// Write a record in the ring. If it is full, wait for a free slot or drop the oldest record.
+    template <typename Writer>
+    void Push(Writer& writer) {
+        while(!ring_.try_push(writer)){
+            if(pool_.expired()){
+                throw spdlog::spdlog_ex("async log: worker pool doesn't exist anymore");
+            }
+            if(overflow_policy_ == spdlog::async_overflow_policy::overrun_oldest){
+                RecordDiscarder discarder;
+                if(ring_.try_pop(discarder)){
+                    overrun_counter_.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+            else {
+                std::this_thread::yield();
+            }
+        }
+        schedule(pool_);
+    }
+
+    std::weak_ptr<details::worker_pool> pool_;
+    ring_type ring_;
+    spdlog::async_overflow_policy overflow_policy_;
+    std::atomic<size_t> overrun_counter_;
+};
+
+} // namespace spdlog_json_config
+
+#endif // __SPDLOG_JSON_CONFIG_DEFERRED_ASYNC_LOGGER_H__
@@ -0,0 +1,206 @@
+#ifndef __SPDLOG_JSON_CONFIG_ADMIN_SERVER_H__
+#define __SPDLOG_JSON_CONFIG_ADMIN_SERVER_H__
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <thread>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include "spdlog/common.h"
+
+
+namespace spdlog_json_config {
+namespace details {
+
+/**
+ * @brief  One background thread serving the commands of a local unix stream socket.
+ *
+ * A client sends commands of one line each, and gets the reply of the handler to each of
+ * them. The clients are served one at a time: a client idle for idle_timeout is
+ * disconnected, so that the next one is served. The socket is created with mode 0600,
+ * replacing a socket left at the path, e.g. by a crashed process, and removed on stop.
+ */
+class admin_server {
+public:
+    /// @brief  Handler of a command, returns the reply
+    typedef std::function<std::string(const std::string& command)> handler;
+
+    const static size_t MAX_COMMAND_SIZE = 4096;
+
+    admin_server(const std::string& socket_path, handler command_handler,
+                 std::chrono::milliseconds idle_timeout = std::chrono::milliseconds(5000))
+        : socket_path_(socket_path), handler_(std::move(command_handler)), idle_timeout_(idle_timeout), fd_(-1) {
+        if(socket_path_.size() >= sizeof(sockaddr_un::sun_path)){
+            spdlog::throw_spdlog_ex("admin_server: socket path too long " + socket_path_);
+        }
+        struct stat st;
+        if(lstat(socket_path_.c_str(), &st) == 0){
+            if(!S_ISSOCK(st.st_mode)){
+                spdlog::throw_spdlog_ex("admin_server: not a socket " + socket_path_);
+            }
+            ::unlink(socket_path_.c_str());
+        }
+
+        fd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if(fd_ < 0){
+            spdlog::throw_spdlog_ex("admin_server: failed creating socket", errno);
+        }
+        struct sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        strncpy(addr.sun_path, socket_path_.c_str(), sizeof(addr.sun_path) - 1);
+        // restricted to the owner before any client can connect
+        if(::bind(fd_, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0 ||
+           ::chmod(socket_path_.c_str(), 0600) != 0 || ::listen(fd_, 4) != 0){
+            int err = errno;
+            ::close(fd_);
+            spdlog::throw_spdlog_ex("admin_server: failed listening on " + socket_path_, err);
+        }
+
+        if(pipe2(stop_pipe_, O_CLOEXEC) != 0){
+            int err = errno;
+            ::close(fd_);
+            ::unlink(socket_path_.c_str());
+            spdlog::throw_spdlog_ex("admin_server: failed creating pipe", err);
+        }
+        thread_ = std::thread(&admin_server::Run, this);
+    }
+
+    admin_server(const admin_server&) = delete;
+    admin_server& operator=(const admin_server&) = delete;
+
+    /// @brief  Stop the thread, disconnecting the client, and remove the socket
+    ~admin_server() {
+        char stop = 0;
+        if(::write(stop_pipe_[1], &stop, 1) < 0){
+            perror("admin_server: stop");
+        }
+        if(thread_.joinable()){
+            thread_.join();
+        }
+        ::close(fd_);
+        ::close(stop_pipe_[0]);
+        ::close(stop_pipe_[1]);
+        ::unlink(socket_path_.c_str());
+    }
+
+    const std::string& socket_path() const {
+        return socket_path_;
+    }
+
+private:
+    void Run() {
+        while(Wait(fd_, -1)){
+            int client = ::accept4(fd_, nullptr, nullptr, SOCK_CLOEXEC);
+            if(client < 0){
+                continue;
+            }
+            bool stopped = !Serve(client);
+            ::close(client);
+            if(stopped){
+                return;
+            }
+        }
+    }
+
+    /// Serve the commands of a client until it disconnects or is idle
+    ///
+    /// @return false if stopped
+    bool Serve(int client) {
+        std::string input;
+        char buffer[512];
+        for(;;){
+            if(!Wait(client, static_cast<int>(idle_timeout_.count()))){
+                return false;
+            }
+            ssize_t size = ::recv(client, buffer, sizeof(buffer), MSG_DONTWAIT);
+            if(size < 0 && (errno == EAGAIN || errno == EINTR)){
+                continue;
+            }
+            if(size <= 0){
+                return true;
+            }
+            input.append(buffer, static_cast<size_t>(size));
+
+            size_t end;
+            while((end = input.find('\n')) != std::string::npos){
+                std::string command = input.substr(0, end);
+                input.erase(0, end + 1);
+                if(!command.empty() && command[command.size() - 1] == '\r'){
+                    command.erase(command.size() - 1);
+                }
+                std::string reply = handler_(command);
+                if(!Send(client, reply)){
+                    return true;
+                }
+            }
+            if(input.size() > MAX_COMMAND_SIZE){
+                Send(client, "ERROR command too long\n");
+                return true;
+            }
+        }
+    }
+
+    /// Wait for fd to be readable, up to timeout_ms (-1 for no timeout)
+    ///
+    /// @return false if stopped, true if readable or on timeout with an error left to recv
+    bool Wait(int fd, int timeout_ms) {
+        struct pollfd fds[2];
+        fds[0].fd = fd;
+        fds[0].events = POLLIN;
+        fds[1].fd = stop_pipe_[0];
+        fds[1].events = POLLIN;
+        for(;;){
+            fds[0].revents = 0;
+            fds[1].revents = 0;
+            int ready = ::poll(fds, 2, timeout_ms);
+            if(ready < 0 && errno == EINTR){
+                continue;
+            }
+            if(ready < 0 || fds[1].revents != 0){
+                return false;
+            }
+            if(ready == 0){
+                // idle client: shut it down, the next recv returns 0
+                ::shutdown(fd, SHUT_RDWR);
+            }
+            return true;
+        }
+    }
+
+    static bool Send(int client, const std::string& reply) {
+        size_t sent = 0;
+        while(sent < reply.size()){
+            ssize_t size = ::send(client, reply.data() + sent, reply.size() - sent, MSG_NOSIGNAL);
+            if(size < 0 && errno == EINTR){
+                continue;
+            }
+            if(size <= 0){
+                return false;
+            }
+            sent += static_cast<size_t>(size);
+        }
+        return true;
+    }
+
+    std::string                 socket_path_;
+    handler                     handler_;
+    std::chrono::milliseconds   idle_timeout_;
+    int                         fd_;
+    int                         stop_pipe_[2];
+    std::thread                 thread_;
+};
+
+} // namespace details
+} // namespace spdlog_json_config
+
+#endif // __SPDLOG_JSON_CONFIG_ADMIN_SERVER_H__
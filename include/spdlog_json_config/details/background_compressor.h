@@ -0,0 +1,261 @@
+#ifndef __SPDLOG_JSON_CONFIG_BACKGROUND_COMPRESSOR_H__
+#define __SPDLOG_JSON_CONFIG_BACKGROUND_COMPRESSOR_H__
+
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <zlib.h>
+#ifdef SPDLOG_JSON_CONFIG_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+
+namespace spdlog_json_config {
+namespace details {
+
+enum class compress_format {
+    gzip,
+    zstd        ///< only if built with SPDLOG_JSON_CONFIG_WITH_ZSTD
+};
+
+/// @brief  Compress the file src into the file dst
+///
+/// @param  cancel  if not nullptr, the compression stops once it is set, checked before each chunk
+/// @return true on success, otherwise false and error is set
+inline bool compress_file(const std::string& src, const std::string& dst,
+                          compress_format format, int level, std::string& error,
+                          const std::atomic<bool>* cancel = nullptr){
+    FILE* in = fopen(src.c_str(), "rb");
+    if(in == nullptr){
+        error = "open " + src + ": " + strerror(errno);
+        return false;
+    }
+
+    const size_t CHUNK_SIZE = 128 * 1024;
+    std::vector<char> chunk(CHUNK_SIZE);
+    bool ok = true;
+
+    if(format == compress_format::gzip){
+        std::string mode = "wb" + std::to_string(level < 0 ? 6 : (level > 9 ? 9 : level));
+        gzFile out = gzopen(dst.c_str(), mode.c_str());
+        if(out == nullptr){
+            error = "open " + dst + ": " + strerror(errno);
+            fclose(in);
+            return false;
+        }
+        size_t size;
+        while(ok && !(cancel != nullptr && *cancel) && (size = fread(chunk.data(), 1, CHUNK_SIZE, in)) > 0){
+            ok = gzwrite(out, chunk.data(), static_cast<unsigned>(size)) == static_cast<int>(size);
+        }
+        ok = (gzclose(out) == Z_OK) && ok && !ferror(in) && !(cancel != nullptr && *cancel);
+        if(!ok) error = "gzip " + src + " failure";
+    }
+#ifdef SPDLOG_JSON_CONFIG_WITH_ZSTD
+    else {
+        FILE* out = fopen(dst.c_str(), "wb");
+        ZSTD_CCtx* cctx = ZSTD_createCCtx();
+        if(out == nullptr || cctx == nullptr){
+            error = "open " + dst + ": " + strerror(errno);
+            if(out != nullptr) fclose(out);
+            ZSTD_freeCCtx(cctx);
+            fclose(in);
+            return false;
+        }
+        ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel, level);
+        std::vector<char> compressed(ZSTD_CStreamOutSize());
+        bool eof = false;
+        while(ok && !eof && !(cancel != nullptr && *cancel)){
+            size_t size = fread(chunk.data(), 1, CHUNK_SIZE, in);
+            eof = size < CHUNK_SIZE;
+            ZSTD_EndDirective mode = eof ? ZSTD_e_end : ZSTD_e_continue;
+            ZSTD_inBuffer input = {chunk.data(), size, 0};
+            size_t remaining;
+            do {
+                ZSTD_outBuffer output = {compressed.data(), compressed.size(), 0};
+                remaining = ZSTD_compressStream2(cctx, &output, &input, mode);
+                ok = !ZSTD_isError(remaining) &&
+                     fwrite(compressed.data(), 1, output.pos, out) == output.pos;
+            } while(ok && (eof ? remaining != 0 : input.pos < input.size));
+        }
+        ZSTD_freeCCtx(cctx);
+        ok = (fclose(out) == 0) && ok && !ferror(in) && !(cancel != nullptr && *cancel);
+        if(!ok) error = "zstd " + src + " failure";
+    }
+#else
+    else {
+        error = "zstd not available";
+        ok = false;
+    }
+#endif
+
+    fclose(in);
+    if(!ok){
+        unlink(dst.c_str());
+    }
+    return ok;
+}
+
+/**
+ * @brief  Owner of the files compressed by the background_compressor.
+ *
+ * It decides where the compressed file goes once done.
+ */
+class compress_target {
+public:
+    compress_target(compress_format format, int level) : format_(format), level_(level) {}
+    virtual ~compress_target() {}
+
+    compress_format format() const { return format_; }
+    int level() const { return level_; }
+    const char* extension() const { return format_ == compress_format::gzip ? ".gz" : ".zst"; }
+
+    /// @brief  Called by the compressor thread once the file src is compressed into compressed
+    virtual void finish(const std::string& src, const std::string& compressed) = 0;
+
+private:
+    compress_format format_;
+    int             level_;
+};
+
+/**
+ * @brief  Low priority threads compressing closed log files.
+ *
+ * Posting a file only queues it: the logging path never waits for a compression. The
+ * files of one target are compressed one at a time, in the order they were posted, so
+ * that the targets can keep their archives ordered. The threads run at the lowest CPU
+ * and I/O priority.
+ *
+ * stop() compresses the files queued until a deadline, the destructor stops at once: the
+ * files not compressed are left in place under the name they were posted with.
+ */
+class background_compressor {
+public:
+    explicit background_compressor(size_t concurrency) : stop_(false), cancel_(false) {
+        if(concurrency == 0) concurrency = 1;
+        for(size_t i = 0; i < concurrency; i++){
+            threads_.emplace_back(&background_compressor::Run, this);
+        }
+    }
+
+    ~background_compressor() {
+        stop(std::chrono::steady_clock::now());
+    }
+
+    background_compressor(const background_compressor&) = delete;
+    background_compressor& operator=(const background_compressor&) = delete;
+
+    /// @brief  Queue the file src to be compressed for target. Ignored once stopped.
+    void post(std::shared_ptr<compress_target> target, const std::string& src) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if(stop_){
+                return;
+            }
+            jobs_.push_back(job{std::move(target), src});
+        }
+        cv_.notify_one();
+    }
+
+    /// @brief  Compress the files queued until deadline, then cancel the rest and join the threads
+    ///
+    /// A compression cancelled removes its temporary file and keeps the file posted.
+    /// The join is bounded by the compression of one chunk.
+    void stop(std::chrono::steady_clock::time_point deadline) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        stop_ = true;
+        cv_.notify_all();
+        cv_.wait_until(lock, deadline, [this](){ return jobs_.empty() && busy_.empty(); });
+        cancel_ = true;
+        jobs_.clear();
+        std::vector<std::thread> threads;
+        threads.swap(threads_);
+        lock.unlock();
+
+        cv_.notify_all();
+        for(auto& thread : threads){
+            thread.join();
+        }
+    }
+
+    /// @brief  Number of files queued or being compressed
+    size_t pending() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return jobs_.size() + busy_.size();
+    }
+
+private:
+    struct job {
+        std::shared_ptr<compress_target> target;
+        std::string                      src;
+    };
+
+    void Run() {
+        setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 19);
+#ifdef SYS_ioprio_set
+        // IOPRIO_WHO_PROCESS of the calling thread, IOPRIO_CLASS_IDLE
+        syscall(SYS_ioprio_set, 1, 0, 3 << 13);
+#endif
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        for(;;){
+            // First job whose target is not being compressed by another thread
+            std::deque<job>::iterator it = jobs_.begin();
+            while(it != jobs_.end() && busy_.count(it->target.get()) > 0){
+                it++;
+            }
+            if(it == jobs_.end()){
+                if(stop_ && jobs_.empty()){
+                    return;
+                }
+                cv_.wait(lock);
+                continue;
+            }
+
+            job current = *it;
+            jobs_.erase(it);
+            busy_.insert(current.target.get());
+            lock.unlock();
+
+            std::string compressed = current.src + current.target->extension() + ".tmp";
+            std::string error;
+            if(compress_file(current.src, compressed, current.target->format(), current.target->level(),
+                             error, &cancel_)){
+                current.target->finish(current.src, compressed);
+            }
+            else if(!cancel_){
+                fprintf(stderr, "background_compressor: %s\n", error.c_str());
+            }
+
+            lock.lock();
+            busy_.erase(current.target.get());
+            cv_.notify_all();
+        }
+    }
+
+    std::deque<job>                 jobs_;
+    std::set<compress_target*>      busy_;
+    bool                            stop_;
+    std::atomic<bool>               cancel_;
+    std::mutex                      mutex_;
+    std::condition_variable         cv_;
+    std::vector<std::thread>        threads_;
+};
+
+} // namespace details
+} // namespace spdlog_json_config
+
+#endif // __SPDLOG_JSON_CONFIG_BACKGROUND_COMPRESSOR_H__
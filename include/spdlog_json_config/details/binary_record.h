@@ -0,0 +1,160 @@
+#ifndef __SPDLOG_JSON_CONFIG_BINARY_RECORD_H__
+#define __SPDLOG_JSON_CONFIG_BINARY_RECORD_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "spdlog/common.h"
+#include "spdlog/details/log_msg.h"
+
+
+namespace spdlog_json_config {
+namespace details {
+
+/**
+ * Binary log file format, in host byte order:
+ *
+ *      file header:    char magic[4] = "SJCB", uint32 version
+ *      record:         uint32 size of the record after this field, uint8 record type
+ *      logger record:  uint32 logger id, logger name
+ *      log record:     int64 time in ns since epoch, uint64 thread id, uint32 logger id,
+ *                      uint8 level, payload
+ *
+ * A logger record defines the id of a logger name, before its first log record.
+ */
+namespace binary_record {
+
+const char     MAGIC[4]         = {'S', 'J', 'C', 'B'};
+const uint32_t VERSION          = 1;
+const size_t   HEADER_SIZE      = sizeof(MAGIC) + sizeof(uint32_t);
+const uint8_t  TYPE_LOGGER      = 0;
+const uint8_t  TYPE_LOG         = 1;
+const uint32_t MAX_RECORD_SIZE  = 64 * 1024 * 1024;
+
+template<typename T>
+inline void append(spdlog::memory_buf_t& buffer, T value){
+    const char* data = reinterpret_cast<const char*>(&value);
+    buffer.append(data, data + sizeof(T));
+}
+
+/// @brief  Append the file header to buffer
+inline void append_header(spdlog::memory_buf_t& buffer){
+    buffer.append(MAGIC, MAGIC + sizeof(MAGIC));
+    append<uint32_t>(buffer, VERSION);
+}
+
+/// @brief  Append a logger record to buffer
+inline void append_logger(spdlog::memory_buf_t& buffer, uint32_t logger_id, spdlog::string_view_t logger_name){
+    append<uint32_t>(buffer, static_cast<uint32_t>(sizeof(uint8_t) + sizeof(uint32_t) + logger_name.size()));
+    append<uint8_t>(buffer, TYPE_LOGGER);
+    append<uint32_t>(buffer, logger_id);
+    buffer.append(logger_name.data(), logger_name.data() + logger_name.size());
+}
+
+/// @brief  Append a log record to buffer
+inline void append_log(spdlog::memory_buf_t& buffer, uint32_t logger_id, const spdlog::details::log_msg& msg){
+    append<uint32_t>(buffer, static_cast<uint32_t>(sizeof(uint8_t) + sizeof(int64_t) + sizeof(uint64_t) +
+                                                   sizeof(uint32_t) + sizeof(uint8_t) + msg.payload.size()));
+    append<uint8_t>(buffer, TYPE_LOG);
+    append<int64_t>(buffer, std::chrono::duration_cast<std::chrono::nanoseconds>(msg.time.time_since_epoch()).count());
+    append<uint64_t>(buffer, static_cast<uint64_t>(msg.thread_id));
+    append<uint32_t>(buffer, logger_id);
+    append<uint8_t>(buffer, static_cast<uint8_t>(msg.level));
+    buffer.append(msg.payload.data(), msg.payload.data() + msg.payload.size());
+}
+
+} // namespace binary_record
+
+/**
+ * @brief  Reader of the log records of a binary log file.
+ *
+ * The log records are returned as log_msg, to be rendered by any formatter. A record cut
+ * at the end of the file, e.g. by a crash, ends the reading.
+ */
+class binary_record_reader {
+public:
+    explicit binary_record_reader(FILE* file) : file_(file) {}
+
+    /// @brief  Read and check the file header
+    bool read_header(){
+        char header[binary_record::HEADER_SIZE];
+        if(fread(header, 1, sizeof(header), file_) != sizeof(header)){
+            return false;
+        }
+        uint32_t version;
+        memcpy(&version, header + sizeof(binary_record::MAGIC), sizeof(version));
+        return memcmp(header, binary_record::MAGIC, sizeof(binary_record::MAGIC)) == 0 &&
+               version == binary_record::VERSION;
+    }
+
+    /// @brief  Read the next log record
+    ///
+    /// @param  [out] msg  the record, valid until the next call
+    /// @return false at the end of the file, or on a corrupted record
+    bool next(spdlog::details::log_msg& msg){
+        for(;;){
+            uint32_t size;
+            if(fread(&size, sizeof(size), 1, file_) != 1 || size == 0 || size > binary_record::MAX_RECORD_SIZE){
+                return false;
+            }
+            record_.resize(size);
+            if(fread(record_.data(), 1, size, file_) != size){
+                return false;
+            }
+
+            const char* data = record_.data();
+            const char* end = data + size;
+            uint8_t type = Read<uint8_t>(data);
+            if(type == binary_record::TYPE_LOGGER){
+                if(end - data < static_cast<ptrdiff_t>(sizeof(uint32_t))) return false;
+                uint32_t logger_id = Read<uint32_t>(data);
+                logger_names_[logger_id] = std::string(data, end);
+                continue;
+            }
+
+            const size_t LOG_HEADER_SIZE = sizeof(int64_t) + sizeof(uint64_t) + sizeof(uint32_t) + sizeof(uint8_t);
+            if(type != binary_record::TYPE_LOG || end - data < static_cast<ptrdiff_t>(LOG_HEADER_SIZE)){
+                return false;
+            }
+            int64_t  time      = Read<int64_t>(data);
+            uint64_t thread_id = Read<uint64_t>(data);
+            uint32_t logger_id = Read<uint32_t>(data);
+            uint8_t  level     = Read<uint8_t>(data);
+
+            logger_name_ = logger_names_[logger_id];
+            msg = spdlog::details::log_msg(
+                      spdlog::log_clock::time_point(std::chrono::duration_cast<spdlog::log_clock::duration>(
+                          std::chrono::nanoseconds(time))),
+                      spdlog::source_loc(), logger_name_,
+                      static_cast<spdlog::level::level_enum>(
+                          level < spdlog::level::n_levels ? level : static_cast<uint8_t>(spdlog::level::off)),
+                      spdlog::string_view_t(data, static_cast<size_t>(end - data)));
+            msg.thread_id = static_cast<size_t>(thread_id);
+            return true;
+        }
+    }
+
+private:
+    template<typename T>
+    static T Read(const char*& data){
+        T value;
+        memcpy(&value, data, sizeof(T));
+        data += sizeof(T);
+        return value;
+    }
+
+    FILE*                                       file_;
+    std::vector<char>                           record_;
+    std::unordered_map<uint32_t, std::string>   logger_names_;
+    std::string                                 logger_name_;
+};
+
+} // namespace details
+} // namespace spdlog_json_config
+
+#endif // __SPDLOG_JSON_CONFIG_BINARY_RECORD_H__
@@ -0,0 +1,198 @@
+#ifndef __SPDLOG_JSON_CONFIG_DEFERRED_ARGS_H__
+#define __SPDLOG_JSON_CONFIG_DEFERRED_ARGS_H__
+
+#include <new>
+#include <string>
+#include <type_traits>
+#include <stdint.h>
+#include <string.h>
+
+#include "spdlog/common.h"
+
+
+namespace spdlog_json_config {
+
+/**
+ * @brief  Opt-in of a user type to the raw copy of the async_deferred loggers.
+ *
+ * Specialize it as std::true_type for a trivially copyable type owning all of its state,
+ * i.e. holding no pointer, reference or iterator: it is formatted on the worker thread,
+ * after the caller may have released what it refers to. Other user types are formatted
+ * by the caller.
+ */
+template <typename T>
+struct is_deferred_value : std::false_type {};
+
+namespace details {
+
+/**
+ * @brief  Write position in the argument area of a record.
+ *
+ * ok is cleared once the arguments don't fit.
+ */
+struct arg_writer {
+    unsigned char* pos;
+    unsigned char* end;
+    bool ok;
+
+    /// @brief  Reserve size bytes aligned to align, nullptr if they don't fit
+    unsigned char* reserve(size_t size, size_t align) {
+        uintptr_t aligned = ((uintptr_t)pos + align - 1) & ~(uintptr_t)(align - 1);
+        if(!ok || aligned + size > (uintptr_t)end){
+            ok = false;
+            return nullptr;
+        }
+        pos = (unsigned char*)(aligned + size);
+        return (unsigned char*)aligned;
+    }
+};
+
+/// @brief  Read position in the argument area of a record.
+struct arg_reader {
+    const unsigned char* pos;
+
+    const unsigned char* take(size_t size, size_t align) {
+        uintptr_t aligned = ((uintptr_t)pos + align - 1) & ~(uintptr_t)(align - 1);
+        pos = (const unsigned char*)(aligned + size);
+        return (const unsigned char*)aligned;
+    }
+};
+
+/// @brief  Arguments copied as string: read back as a string view on the record
+template <typename T>
+struct is_string_arg : std::integral_constant<bool,
+    std::is_same<T, char*>::value || std::is_same<T, const char*>::value ||
+    std::is_same<T, std::string>::value || std::is_same<T, spdlog::string_view_t>::value> {};
+
+/**
+ * @brief  Arguments copied byte for byte: arithmetic, enum, void* and opted-in types.
+ *
+ * Other trivially copyable types may refer to the caller's data, e.g. fmt::join views,
+ * iterators, std::reference_wrapper or structs holding a const char*, so they are not.
+ */
+template <typename T>
+struct is_value_arg : std::integral_constant<bool,
+    std::is_arithmetic<T>::value || std::is_enum<T>::value ||
+    std::is_same<T, void*>::value || std::is_same<T, const void*>::value ||
+    is_deferred_value<T>::value> {};
+
+template <typename T, typename Enable = void>
+struct arg_codec;
+
+template <typename T>
+struct arg_codec<T, typename std::enable_if<is_string_arg<T>::value>::type> {
+    static void encode(arg_writer& w, const T& value) {
+        spdlog::string_view_t view = ToView(value);
+        unsigned char* size_pos = w.reserve(sizeof(uint32_t), alignof(uint32_t));
+        unsigned char* data_pos = w.reserve(view.size(), 1);
+        if(size_pos != nullptr && data_pos != nullptr){
+            uint32_t size = (uint32_t)view.size();
+            memcpy(size_pos, &size, sizeof(size));
+            if(size > 0){
+                memcpy(data_pos, view.data(), size);
+            }
+        }
+    }
+
+    static spdlog::string_view_t decode(arg_reader& r) {
+        uint32_t size;
+        memcpy(&size, r.take(sizeof(uint32_t), alignof(uint32_t)), sizeof(size));
+        return spdlog::string_view_t((const char*)r.take(size, 1), size);
+    }
+
+private:
+    static spdlog::string_view_t ToView(const char* value) {
+        return value == nullptr ? spdlog::string_view_t("", 0) : spdlog::string_view_t(value, strlen(value));
+    }
+
+    static spdlog::string_view_t ToView(const std::string& value) {
+        return spdlog::string_view_t(value.data(), value.size());
+    }
+
+    static spdlog::string_view_t ToView(const spdlog::string_view_t& value) {
+        return value;
+    }
+};
+
+template <typename T>
+struct arg_codec<T, typename std::enable_if<is_value_arg<T>::value>::type> {
+    static_assert(std::is_trivially_copyable<T>::value, "is_deferred_value: the type must be trivially copyable");
+
+    static void encode(arg_writer& w, const T& value) {
+        unsigned char* p = w.reserve(sizeof(T), alignof(T));
+        if(p != nullptr){
+            new (p) T(value);
+        }
+    }
+
+    static const T& decode(arg_reader& r) {
+        return *reinterpret_cast<const T*>(r.take(sizeof(T), alignof(T)));
+    }
+};
+
+template <typename... Ts>
+struct type_list {};
+
+template <size_t... Is>
+struct indices {};
+
+template <size_t N, size_t... Is>
+struct make_indices : make_indices<N - 1, N - 1, Is...> {};
+
+template <size_t... Is>
+struct make_indices<0, Is...> : indices<Is...> {};
+
+template <typename... Ts>
+struct all_deferrable : std::true_type {};
+
+template <typename T, typename... Ts>
+struct all_deferrable<T, Ts...> : std::integral_constant<bool,
+    (is_string_arg<T>::value || is_value_arg<T>::value) && all_deferrable<Ts...>::value> {};
+
+/**
+ * @brief  Copy of the arguments of one log call, formatted later by the worker.
+ *
+ * encode() writes the arguments in the argument area of a record. format() reads them
+ * back in the same order and formats them with the format string.
+ */
+template <typename... Args>
+struct deferred_args {
+    const static bool deferrable = all_deferrable<typename std::decay<Args>::type...>::value;
+
+    static bool encode(arg_writer& w, const Args&... args) {
+        EncodeEach(w, args...);
+        return w.ok;
+    }
+
+    static void format(spdlog::string_view_t fmt, const unsigned char* data, spdlog::memory_buf_t& out) {
+        arg_reader r = { data };
+        FormatEach(fmt, out, r, type_list<typename std::decay<Args>::type...>());
+    }
+
+private:
+    static void EncodeEach(arg_writer&) {}
+
+    template <typename T, typename... Ts>
+    static void EncodeEach(arg_writer& w, const T& value, const Ts&... rest) {
+        arg_codec<typename std::decay<T>::type>::encode(w, value);
+        EncodeEach(w, rest...);
+    }
+
+    template <typename... Decoded>
+    static void FormatEach(spdlog::string_view_t fmt, spdlog::memory_buf_t& out, arg_reader&,
+                           type_list<>, const Decoded&... decoded) {
+        fmt::vformat_to(fmt::appender(out), fmt, fmt::make_format_args(decoded...));
+    }
+
+    template <typename T, typename... Ts, typename... Decoded>
+    static void FormatEach(spdlog::string_view_t fmt, spdlog::memory_buf_t& out, arg_reader& r,
+                           type_list<T, Ts...>, const Decoded&... decoded) {
+        const auto& value = arg_codec<T>::decode(r);
+        FormatEach(fmt, out, r, type_list<Ts...>(), decoded..., value);
+    }
+};
+
+} // namespace details
+} // namespace spdlog_json_config
+
+#endif // __SPDLOG_JSON_CONFIG_DEFERRED_ARGS_H__
@@ -0,0 +1,155 @@
+#ifndef __SPDLOG_JSON_CONFIG_FILE_ARCHIVE_H__
+#define __SPDLOG_JSON_CONFIG_FILE_ARCHIVE_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "spdlog/common.h"
+#include "spdlog/details/os.h"
+#include "spdlog/sinks/rotating_file_sink.h"
+
+#include "background_compressor.h"
+
+
+namespace spdlog_json_config {
+namespace details {
+
+/**
+ * @brief  Compressed archives of a rotating file sink.
+ *
+ * On rotation, the file just closed, base.1.log, is moved out of the rotation under a
+ * pending name and queued to the compressor. Once compressed, the archives base.N.log.gz
+ * are shifted like the rotated files, the last one beyond max_files is removed, and the
+ * new archive becomes base.1.log.gz.
+ *
+ * The pending files left by a previous run, e.g. stopped before compressing them, are
+ * queued again when the sink opens its file, oldest first.
+ */
+class rotating_archive : public compress_target, public std::enable_shared_from_this<rotating_archive> {
+public:
+    rotating_archive(compress_format format, int level, const spdlog::filename_t& base_filename,
+                     size_t max_files, std::shared_ptr<background_compressor> compressor)
+        : compress_target(format, level), base_filename_(base_filename), max_files_(max_files),
+          compressor_(std::move(compressor)), opened_(false), seq_(0) {}
+
+    /// @brief  File event handlers to give to the rotating file sink
+    spdlog::file_event_handlers event_handlers() {
+        std::shared_ptr<rotating_archive> self = shared_from_this();
+        spdlog::file_event_handlers handlers;
+        handlers.after_open = [self](const spdlog::filename_t&, std::FILE*){ self->OnOpen(); };
+        return handlers;
+    }
+
+    void finish(const std::string& src, const std::string& compressed) override {
+        for(size_t i = max_files_; i > 1; i--){
+            std::string from = ArchiveName(i - 1);
+            if(spdlog::details::os::path_exists(from)){
+                rename(from.c_str(), ArchiveName(i).c_str());
+            }
+        }
+        rename(compressed.c_str(), ArchiveName(1).c_str());
+        unlink(src.c_str());
+    }
+
+private:
+    /// Called by the sink, with its lock, when the file is opened and after each rotation
+    void OnOpen() {
+        spdlog::filename_t rotated = spdlog::sinks::rotating_file_sink_st::calc_filename(base_filename_, 1);
+        if(!opened_){
+            opened_ = true;
+            std::vector<uint64_t> leftovers = FindPending(rotated);
+            for(uint64_t seq : leftovers){
+                compressor_->post(shared_from_this(), rotated + "." + std::to_string(seq));
+            }
+            seq_ = leftovers.empty() ? 0 : leftovers.back() + 1;
+            return;
+        }
+        spdlog::filename_t pending = rotated + "." + std::to_string(seq_++);
+        if(rename(rotated.c_str(), pending.c_str()) == 0){
+            compressor_->post(shared_from_this(), pending);
+        }
+    }
+
+    /// Sequence numbers of the pending files rotated.<seq> in the directory of rotated, sorted
+    static std::vector<uint64_t> FindPending(const spdlog::filename_t& rotated) {
+        std::vector<uint64_t> seqs;
+        size_t slash = rotated.rfind('/');
+        std::string dir = (slash == std::string::npos) ? std::string(".") : rotated.substr(0, slash + 1);
+        std::string prefix = (slash == std::string::npos ? rotated : rotated.substr(slash + 1)) + ".";
+
+        DIR* dirp = opendir(dir.c_str());
+        if(dirp == nullptr){
+            return seqs;
+        }
+        struct dirent* entry;
+        while((entry = readdir(dirp)) != nullptr){
+            std::string name(entry->d_name);
+            if(name.size() <= prefix.size() || name.compare(0, prefix.size(), prefix) != 0 ||
+               name.find_first_not_of("0123456789", prefix.size()) != std::string::npos){
+                continue;
+            }
+            seqs.push_back(strtoull(name.c_str() + prefix.size(), nullptr, 10));
+        }
+        closedir(dirp);
+        std::sort(seqs.begin(), seqs.end());
+        return seqs;
+    }
+
+    std::string ArchiveName(size_t index) const {
+        return spdlog::sinks::rotating_file_sink_st::calc_filename(base_filename_, index) + extension();
+    }
+
+    spdlog::filename_t                      base_filename_;
+    size_t                                  max_files_;
+    std::shared_ptr<background_compressor>  compressor_;
+    bool                                    opened_;
+    uint64_t                                seq_;
+};
+
+/**
+ * @brief  Compressed archives of a daily file sink.
+ *
+ * When the sink opens the file of a new day, the file of the previous day is queued to
+ * the compressor, and replaced by its compressed file, e.g. daily_2024-01-01.log.gz.
+ */
+class daily_archive : public compress_target, public std::enable_shared_from_this<daily_archive> {
+public:
+    daily_archive(compress_format format, int level, std::shared_ptr<background_compressor> compressor)
+        : compress_target(format, level), compressor_(std::move(compressor)) {}
+
+    /// @brief  File event handlers to give to the daily file sink
+    spdlog::file_event_handlers event_handlers() {
+        std::shared_ptr<daily_archive> self = shared_from_this();
+        spdlog::file_event_handlers handlers;
+        handlers.after_open = [self](const spdlog::filename_t& filename, std::FILE*){ self->OnOpen(filename); };
+        return handlers;
+    }
+
+    void finish(const std::string& src, const std::string& compressed) override {
+        rename(compressed.c_str(), (src + extension()).c_str());
+        unlink(src.c_str());
+    }
+
+private:
+    /// Called by the sink, with its lock, when a file is opened
+    void OnOpen(const spdlog::filename_t& filename) {
+        if(!current_filename_.empty() && current_filename_ != filename){
+            compressor_->post(shared_from_this(), current_filename_);
+        }
+        current_filename_ = filename;
+    }
+
+    std::shared_ptr<background_compressor>  compressor_;
+    spdlog::filename_t                      current_filename_;
+};
+
+} // namespace details
+} // namespace spdlog_json_config
+
+#endif // __SPDLOG_JSON_CONFIG_FILE_ARCHIVE_H__
@@ -0,0 +1,170 @@
+#ifndef __SPDLOG_JSON_CONFIG_FLIGHT_RECORDER_H__
+#define __SPDLOG_JSON_CONFIG_FLIGHT_RECORDER_H__
+
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <zlib.h>
+
+
+namespace spdlog_json_config {
+namespace details {
+
+/**
+ * Flight recorder file format, in host byte order:
+ *
+ *      file header (4KB):  char magic[4] = "SJCF", uint32 version, uint64 capacity,
+ *                          uint64 write offset, uint64 next sequence number
+ *      ring:               capacity bytes of records, aligned on 8 bytes
+ *      record:             uint32 magic, uint32 text size, uint64 sequence number,
+ *                          uint32 crc32 of the sequence number and text, uint32 level, text
+ *
+ * A record which does not fit before the end of the ring goes to its beginning, the end
+ * is zeroed. The records are recovered by their checksum, not by the header.
+ */
+namespace flight_recorder {
+
+const char     MAGIC[4]         = {'S', 'J', 'C', 'F'};
+const uint32_t VERSION          = 1;
+const size_t   HEADER_SIZE      = 4096;
+const uint32_t RECORD_MAGIC     = 0x52434A53;   // "SJCR"
+const size_t   ALIGNMENT        = 8;
+
+struct file_header {
+    char        magic[4];
+    uint32_t    version;
+    uint64_t    capacity;
+    uint64_t    write_offset;
+    uint64_t    next_seq;
+};
+
+struct record_header {
+    uint32_t    magic;
+    uint32_t    size;
+    uint64_t    seq;
+    uint32_t    crc;
+    uint32_t    level;
+};
+
+inline size_t aligned_size(size_t text_size){
+    return (sizeof(record_header) + text_size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+}
+
+inline uint32_t checksum(uint64_t seq, const char* text, size_t size){
+    uLong crc = crc32(0L, reinterpret_cast<const Bytef*>(&seq), sizeof(seq));
+    return static_cast<uint32_t>(crc32(crc, reinterpret_cast<const Bytef*>(text), static_cast<uInt>(size)));
+}
+
+/// @brief  A record recovered from a flight recorder file
+struct record {
+    uint64_t    seq;
+    uint32_t    level;
+    std::string text;
+};
+
+/**
+ * @brief  Recover the records of a flight recorder file.
+ *
+ * Every offset of the ring is checked for a record with a valid checksum. The records
+ * are ordered by sequence number, and only the last run of consecutive sequence numbers
+ * is kept, so that the stale records of a previous turn of the ring are dropped.
+ *
+ * @param  [in]  filename   the flight recorder file
+ * @param  [in]  max_bytes  max bytes of text to recover, the newest ones, 0 for all
+ * @param  [out] records    the records, oldest first
+ * @param  [out] error      the error if any
+ * @return true if success, otherwise false
+ */
+inline bool read(const std::string& filename, size_t max_bytes, std::vector<record>& records, std::string& error){
+    records.clear();
+    int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fd < 0){
+        error = "open " + filename + ": " + strerror(errno);
+        return false;
+    }
+    struct stat st;
+    if(fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < HEADER_SIZE){
+        error = filename + " is not a flight recorder file";
+        ::close(fd);
+        return false;
+    }
+    size_t file_size = static_cast<size_t>(st.st_size);
+    void* mapping = mmap(nullptr, file_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if(mapping == MAP_FAILED){
+        error = "mmap " + filename + ": " + strerror(errno);
+        return false;
+    }
+
+    const char* base = static_cast<const char*>(mapping);
+    file_header header;
+    memcpy(&header, base, sizeof(header));
+    if(memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION ||
+       header.capacity > file_size - HEADER_SIZE){
+        error = filename + " is not a flight recorder file";
+        munmap(mapping, file_size);
+        return false;
+    }
+
+    struct found {
+        uint64_t    seq;
+        size_t      offset;
+        bool operator<(const found& other) const { return seq < other.seq; }
+    };
+    std::vector<found> found_records;
+    const char* ring = base + HEADER_SIZE;
+    size_t capacity = static_cast<size_t>(header.capacity);
+    for(size_t offset = 0; offset + sizeof(record_header) <= capacity; ){
+        record_header rec;
+        memcpy(&rec, ring + offset, sizeof(rec));
+        if(rec.magic == RECORD_MAGIC && offset + aligned_size(rec.size) <= capacity &&
+           rec.crc == checksum(rec.seq, ring + offset + sizeof(rec), rec.size)){
+            found_records.push_back(found{rec.seq, offset});
+            offset += aligned_size(rec.size);
+        }
+        else {
+            offset += ALIGNMENT;
+        }
+    }
+
+    // Last run of consecutive sequence numbers, within max_bytes
+    std::sort(found_records.begin(), found_records.end());
+    size_t first = found_records.size();
+    size_t bytes = 0;
+    while(first > 0){
+        const found& current = found_records[first - 1];
+        if(first < found_records.size() && current.seq + 1 != found_records[first].seq){
+            break;
+        }
+        record_header rec;
+        memcpy(&rec, ring + current.offset, sizeof(rec));
+        if(max_bytes > 0 && bytes + rec.size > max_bytes){
+            break;
+        }
+        bytes += rec.size;
+        first--;
+    }
+
+    for(size_t i = first; i < found_records.size(); i++){
+        record_header rec;
+        memcpy(&rec, ring + found_records[i].offset, sizeof(rec));
+        const char* text = ring + found_records[i].offset + sizeof(rec);
+        records.push_back(record{rec.seq, rec.level, std::string(text, rec.size)});
+    }
+    munmap(mapping, file_size);
+    return true;
+}
+
+} // namespace flight_recorder
+} // namespace details
+} // namespace spdlog_json_config
+
+#endif // __SPDLOG_JSON_CONFIG_FLIGHT_RECORDER_H__
@@ -0,0 +1,205 @@
+#ifndef __SPDLOG_JSON_CONFIG_LEVEL_CONTROL_H__
+#define __SPDLOG_JSON_CONFIG_LEVEL_CONTROL_H__
+
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <string>
+
+
+namespace spdlog_json_config {
+namespace details {
+
+/**
+ * Level control file format, in host byte order:
+ *
+ *      file header (64B):  char magic[4] = "SJCL", uint32 version, uint32 slot count, uint32 pid
+ *      slot (64B):         int32 level, uint32 reserved, char name[56], one per logger id
+ *
+ * The levels are the values of spdlog::level::level_enum, read and written in place with
+ * relaxed atomic accesses: by the process owning the file, and by the processes changing
+ * its levels. The name of an unused slot is empty, a longer name is truncated.
+ */
+namespace level_control {
+
+const char     MAGIC[4]         = {'S', 'J', 'C', 'L'};
+const uint32_t VERSION          = 1;
+const size_t   NAME_SIZE        = 56;
+
+/// Names of the levels, by value of spdlog::level::level_enum
+const char* const LEVEL_NAMES[] = {"trace", "debug", "info", "warning", "error", "critical", "off"};
+const int32_t     LEVEL_COUNT   = 7;
+
+struct file_header {
+    char        magic[4];
+    uint32_t    version;
+    uint32_t    slot_count;
+    uint32_t    pid;
+    char        reserved[48];
+};
+
+struct slot {
+    int32_t     level;
+    uint32_t    reserved;
+    char        name[NAME_SIZE];
+};
+
+/// @brief  Level of a name of LEVEL_NAMES, or of "warn" and "err", -1 if none
+inline int32_t level_from_name(const std::string& name){
+    if(name == "warn") return 3;
+    if(name == "err") return 4;
+    for(int32_t level = 0; level < LEVEL_COUNT; level++){
+        if(name == LEVEL_NAMES[level]) return level;
+    }
+    return -1;
+}
+
+/**
+ * @brief  Mapping of a level control file.
+ *
+ * The mapping is kept until the block is destroyed, even if the file is removed.
+ * create() again replaces the file mapped in place, at the same address: a thread still
+ * reading the previous file reads the new one, never unmapped memory.
+ */
+class block {
+public:
+    block() : map_(nullptr), size_(0) {}
+
+    ~block(){
+        if(map_ != nullptr){
+            munmap(map_, size_);
+        }
+    }
+
+    block(const block&) = delete;
+    block& operator=(const block&) = delete;
+
+    /// @brief  Create the file of the process, with slot_count unused slots
+    ///
+    /// A file at the path is replaced, not truncated: a process mapping it keeps it.
+    /// If a file is already mapped by the block, slot_count must be the same.
+    ///
+    /// @return true if success, otherwise false and error is set
+    bool create(const std::string& path, uint32_t slot_count, std::string& error){
+        ::unlink(path.c_str());
+        int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+        if(fd < 0){
+            error = "open " + path + ": " + strerror(errno);
+            return false;
+        }
+        size_t size = sizeof(file_header) + slot_count * sizeof(slot);
+        if(ftruncate(fd, static_cast<off_t>(size)) != 0 || !Map(fd, size, path, error)){
+            if(error.empty()) error = "resize " + path + ": " + strerror(errno);
+            ::close(fd);
+            ::unlink(path.c_str());
+            return false;
+        }
+        ::close(fd);
+
+        file_header* header = static_cast<file_header*>(map_);
+        header->version = VERSION;
+        header->slot_count = slot_count;
+        header->pid = static_cast<uint32_t>(getpid());
+        for(uint32_t id = 0; id < slot_count; id++){
+            slots()[id].level = LEVEL_COUNT - 1;
+        }
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        memcpy(header->magic, MAGIC, sizeof(MAGIC));
+        return true;
+    }
+
+    /// @brief  Map the file of a process, to change its levels
+    ///
+    /// @return true if success, otherwise false and error is set
+    bool open(const std::string& path, std::string& error){
+        int fd = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+        if(fd < 0){
+            error = "open " + path + ": " + strerror(errno);
+            return false;
+        }
+        struct stat st;
+        if(fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(file_header)){
+            error = path + ": not a level control file";
+            ::close(fd);
+            return false;
+        }
+        bool mapped = Map(fd, static_cast<size_t>(st.st_size), path, error);
+        ::close(fd);
+        if(!mapped){
+            return false;
+        }
+
+        const file_header* header = static_cast<const file_header*>(map_);
+        if(memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0 || header->version != VERSION ||
+           sizeof(file_header) + header->slot_count * sizeof(slot) > size_){
+            error = path + ": not a level control file of version " + std::to_string(VERSION);
+            return false;
+        }
+        return true;
+    }
+
+    uint32_t slot_count() const {
+        return static_cast<const file_header*>(map_)->slot_count;
+    }
+
+    /// @brief  Pid of the process owning the file
+    uint32_t pid() const {
+        return static_cast<const file_header*>(map_)->pid;
+    }
+
+    int32_t level(uint32_t id) const {
+        return __atomic_load_n(&slots()[id].level, __ATOMIC_RELAXED);
+    }
+
+    void set_level(uint32_t id, int32_t level){
+        __atomic_store_n(&slots()[id].level, level, __ATOMIC_RELAXED);
+    }
+
+    std::string name(uint32_t id) const {
+        const char* name = slots()[id].name;
+        return std::string(name, strnlen(name, NAME_SIZE));
+    }
+
+    /// @brief  Publish a logger in its slot
+    void set_slot(uint32_t id, const std::string& name, int32_t level){
+        slot& current = slots()[id];
+        memset(current.name, 0, NAME_SIZE);
+        memcpy(current.name, name.data(), std::min(name.size(), NAME_SIZE - 1));
+        set_level(id, level);
+    }
+
+private:
+    /// Map the file, in place of the file mapped if any
+    bool Map(int fd, size_t size, const std::string& path, std::string& error){
+        if(map_ != nullptr && size != size_){
+            error = path + ": size differs from the file mapped";
+            return false;
+        }
+        void* map = mmap(map_, size, PROT_READ | PROT_WRITE, MAP_SHARED | (map_ != nullptr ? MAP_FIXED : 0), fd, 0);
+        if(map == MAP_FAILED){
+            error = "mmap " + path + ": " + strerror(errno);
+            return false;
+        }
+        map_ = map;
+        size_ = size;
+        return true;
+    }
+
+    slot* slots() const {
+        return reinterpret_cast<slot*>(static_cast<char*>(map_) + sizeof(file_header));
+    }
+
+    void*   map_;
+    size_t  size_;
+};
+
+} // namespace level_control
+} // namespace details
+} // namespace spdlog_json_config
+
+#endif // __SPDLOG_JSON_CONFIG_LEVEL_CONTROL_H__
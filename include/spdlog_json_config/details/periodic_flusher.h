@@ -0,0 +1,112 @@
+#ifndef __SPDLOG_JSON_CONFIG_PERIODIC_FLUSHER_H__
+#define __SPDLOG_JSON_CONFIG_PERIODIC_FLUSHER_H__
+
+#include <stdio.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../sinks/dirty_tracking_sink.h"
+#include "../sinks/buffered_sink.h"
+
+
+namespace spdlog_json_config {
+namespace details {
+
+/**
+ * @brief  One background thread flushing the tracked sinks every interval.
+ *
+ * Only the sinks written since the previous tick are flushed, idle sinks cost
+ * one atomic load per tick.
+ *
+ * The same thread writes the buffers of the buffered sinks whose oldest record is older
+ * than their max delay. They are checked every quarter of the smallest max delay.
+ */
+class periodic_flusher {
+public:
+    /// @param  interval        flush interval of the tracked sinks, 0 if none
+    /// @param  sinks           the tracked sinks
+    /// @param  buffered_sinks  the buffered sinks with a max delay
+    periodic_flusher(std::chrono::milliseconds interval,
+                     std::vector<std::shared_ptr<sinks::dirty_tracking_sink>> sinks,
+                     std::vector<std::shared_ptr<sinks::buffered_sink>> buffered_sinks =
+                         std::vector<std::shared_ptr<sinks::buffered_sink>>())
+        : interval_(interval), sinks_(std::move(sinks)), buffered_sinks_(std::move(buffered_sinks)),
+          tick_(interval), active_(true) {
+        for(auto& sink : buffered_sinks_){
+            std::chrono::milliseconds tick = std::max(sink->max_delay() / 4, std::chrono::milliseconds(1));
+            if(tick_.count() == 0 || tick < tick_) tick_ = tick;
+        }
+        thread_ = std::thread(&periodic_flusher::Run, this);
+    }
+
+    periodic_flusher(const periodic_flusher&) = delete;
+    periodic_flusher& operator=(const periodic_flusher&) = delete;
+
+    /// @brief  Stop the flusher thread. Flush the dirty sinks one last time.
+    ~periodic_flusher() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            active_ = false;
+        }
+        cv_.notify_one();
+        if(thread_.joinable()){
+            thread_.join();
+        }
+    }
+
+private:
+    void Run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        std::chrono::steady_clock::time_point next_flush = std::chrono::steady_clock::now() + interval_;
+        while(active_){
+            cv_.wait_for(lock, tick_);
+            std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+            WriteExpiredBuffers(now);
+            if(interval_.count() > 0 && (now >= next_flush || !active_)){
+                FlushDirtySinks();
+                next_flush = now + interval_;
+            }
+        }
+    }
+
+    void WriteExpiredBuffers(std::chrono::steady_clock::time_point now) {
+        for(auto& sink : buffered_sinks_){
+            try{
+                sink->write_if_expired(now);
+            }
+            catch(const std::exception& ex){
+                fprintf(stderr, "periodic_flusher: write failure: %s\n", ex.what());
+            }
+        }
+    }
+
+    void FlushDirtySinks() {
+        for(auto& sink : sinks_){
+            try{
+                sink->flush_if_dirty();
+            }
+            catch(const std::exception& ex){
+                fprintf(stderr, "periodic_flusher: flush failure: %s\n", ex.what());
+            }
+        }
+    }
+
+    std::chrono::milliseconds interval_;
+    std::vector<std::shared_ptr<sinks::dirty_tracking_sink>> sinks_;
+    std::vector<std::shared_ptr<sinks::buffered_sink>> buffered_sinks_;
+    std::chrono::milliseconds tick_;
+    bool active_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::thread thread_;
+};
+
+} // namespace details
+} // namespace spdlog_json_config
+
+#endif // __SPDLOG_JSON_CONFIG_PERIODIC_FLUSHER_H__
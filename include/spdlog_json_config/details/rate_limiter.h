@@ -0,0 +1,123 @@
+#ifndef __SPDLOG_JSON_CONFIG_RATE_LIMITER_H__
+#define __SPDLOG_JSON_CONFIG_RATE_LIMITER_H__
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+
+
+namespace spdlog_json_config {
+namespace details {
+
+/**
+ * @brief  Lock free token bucket, as a generic cell rate algorithm.
+ *
+ * The bucket is one atomic theoretical arrival time (tat): a cost of n tokens moves it by
+ * n intervals, and is accepted if the tat stays within the burst tolerance ahead of now.
+ * The tat is updated with a compare and swap, so concurrent callers never wait on a lock.
+ */
+class token_bucket {
+public:
+    /// @param  rate   tokens per second, 0 for unlimited
+    /// @param  burst  tokens accepted at once after an idle period
+    token_bucket(double rate, double burst)
+        : interval_(rate > 0 ? 1e9 / rate : 0), tolerance_(rate > 0 ? (burst > 1 ? burst - 1 : 0) * 1e9 / rate : 0),
+          tat_(0) {}
+
+    bool unlimited() const {
+        return interval_ == 0;
+    }
+
+    /// @brief  Take cost tokens at now, in ns of the steady clock
+    bool take(int64_t now, double cost) {
+        if(unlimited()){
+            return true;
+        }
+        int64_t increment = static_cast<int64_t>(interval_ * cost);
+        int64_t tat = tat_.load(std::memory_order_relaxed);
+        for(;;){
+            int64_t start = tat > now ? tat : now;
+            if(start - now > static_cast<int64_t>(tolerance_)){
+                return false;
+            }
+            if(tat_.compare_exchange_weak(tat, start + increment, std::memory_order_relaxed)){
+                return true;
+            }
+        }
+    }
+
+private:
+    double                  interval_;      // ns per token
+    double                  tolerance_;     // ns the tat may be ahead of now
+    std::atomic<int64_t>    tat_;
+};
+
+/**
+ * @brief  Rate limit of records, by count and by bytes.
+ *
+ * A record is accepted if both buckets have tokens. The suppressed records are counted,
+ * and a summary is due every summary_interval while some are suppressed.
+ */
+class rate_limiter {
+public:
+    /// @param  messages_per_sec  records per second, 0 for unlimited
+    /// @param  burst             records accepted at once, defaults to messages_per_sec
+    /// @param  bytes_per_sec     payload bytes per second, 0 for unlimited, with a burst of one second
+    rate_limiter(double messages_per_sec, double burst, double bytes_per_sec,
+                 std::chrono::milliseconds summary_interval)
+        : messages_(messages_per_sec, burst > 0 ? burst : messages_per_sec),
+          bytes_(bytes_per_sec, bytes_per_sec),
+          summary_interval_(std::chrono::duration_cast<std::chrono::nanoseconds>(summary_interval).count()),
+          suppressed_(0), suppressed_bytes_(0), next_summary_(0) {}
+
+    static int64_t now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    /// @brief  Whether a record of size bytes is accepted at now, otherwise it is counted
+    bool allow(int64_t now, size_t size) {
+        if(bytes_.take(now, static_cast<double>(size)) && messages_.take(now, 1)){
+            return true;
+        }
+        suppressed_.fetch_add(1, std::memory_order_relaxed);
+        suppressed_bytes_.fetch_add(size, std::memory_order_relaxed);
+        return false;
+    }
+
+    /// @brief  Take the counts of the suppressed records if a summary is due at now
+    ///
+    /// @return false if no summary is due, e.g. nothing was suppressed
+    bool take_summary(int64_t now, uint64_t& suppressed, uint64_t& suppressed_bytes) {
+        if(suppressed_.load(std::memory_order_relaxed) == 0){
+            return false;
+        }
+        int64_t next = next_summary_.load(std::memory_order_relaxed);
+        if(now < next || !next_summary_.compare_exchange_strong(next, now + summary_interval_, std::memory_order_relaxed)){
+            return false;
+        }
+        suppressed = suppressed_.exchange(0, std::memory_order_relaxed);
+        suppressed_bytes = suppressed_bytes_.exchange(0, std::memory_order_relaxed);
+        return suppressed > 0;
+    }
+
+    /// @brief  Text of a summary
+    static std::string summary(uint64_t suppressed, uint64_t suppressed_bytes) {
+        return "rate limit: " + std::to_string(suppressed) + " messages (" +
+               std::to_string(suppressed_bytes) + " bytes) suppressed";
+    }
+
+private:
+    token_bucket            messages_;
+    token_bucket            bytes_;
+    int64_t                 summary_interval_;
+    std::atomic<uint64_t>   suppressed_;
+    std::atomic<uint64_t>   suppressed_bytes_;
+    std::atomic<int64_t>    next_summary_;
+};
+
+} // namespace details
+} // namespace spdlog_json_config
+
+#endif // __SPDLOG_JSON_CONFIG_RATE_LIMITER_H__
@@ -0,0 +1,142 @@
+#ifndef __SPDLOG_JSON_CONFIG_RECORD_RING_H__
+#define __SPDLOG_JSON_CONFIG_RECORD_RING_H__
+
+#include <atomic>
+#include <vector>
+#include <stddef.h>
+
+
+namespace spdlog_json_config {
+namespace details {
+
+/**
+ * @brief  Bounded lock free multi producer queue of fixed size slots.
+ *
+ * Records are written and read in place in the slots, nothing is allocated after
+ * construction. A producer claims a slot with one CAS, writes the record and publishes
+ * it by storing the slot sequence (Dmitry Vyukov's bounded MPMC queue).
+ *
+ * @tparam SlotSize  size of a slot in bytes, including the slot sequence
+ */
+template <size_t SlotSize>
+class record_ring {
+public:
+    const static size_t DATA_SIZE = SlotSize - 16;   ///< bytes of a slot available to a record
+
+    /// @param capacity  number of slots, rounded up to a power of 2
+    explicit record_ring(size_t capacity)
+        : slots_(RoundUp(capacity)), mask_(slots_.size() - 1),
+          enqueue_pos_(0), dequeue_pos_(0) {
+        for(size_t i = 0; i < slots_.size(); i++){
+            slots_[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    record_ring(const record_ring&) = delete;
+    record_ring& operator=(const record_ring&) = delete;
+
+    /// @brief  Write a record in a free slot
+    ///
+    /// @param  writer  callable invoked as writer(unsigned char* data) to write the record
+    /// @return false if the ring is full
+    template <typename Writer>
+    bool try_push(Writer& writer) {
+        size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        slot* s;
+        for(;;){
+            s = &slots_[pos & mask_];
+            size_t seq = s->seq.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            if(diff == 0){
+                if(enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)){
+                    break;
+                }
+            }
+            else if(diff < 0){
+                return false;
+            }
+            else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+
+        writer(s->data);
+        s->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// @brief  Read the oldest record and release its slot
+    ///
+    /// @param  reader  callable invoked as reader(const unsigned char* data) to read the record
+    /// @return false if the ring is empty
+    template <typename Reader>
+    bool try_pop(Reader& reader) {
+        size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        slot* s;
+        for(;;){
+            s = &slots_[pos & mask_];
+            size_t seq = s->seq.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+            if(diff == 0){
+                if(dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)){
+                    break;
+                }
+            }
+            else if(diff < 0){
+                return false;
+            }
+            else {
+                pos = dequeue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+
+        reader(static_cast<const unsigned char*>(s->data));
+        s->seq.store(pos + mask_ + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// @brief  Approximate number of records in the ring
+    size_t size() const {
+        size_t enqueue_pos = enqueue_pos_.load(std::memory_order_relaxed);
+        size_t dequeue_pos = dequeue_pos_.load(std::memory_order_relaxed);
+        return enqueue_pos > dequeue_pos ? enqueue_pos - dequeue_pos : 0;
+    }
+
+    /// @brief  Whether the oldest slot holds a published record
+    bool empty() const {
+        size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        return slots_[pos & mask_].seq.load(std::memory_order_acquire) != pos + 1;
+    }
+
+    size_t capacity() const {
+        return slots_.size();
+    }
+
+private:
+    struct slot {
+        std::atomic<size_t> seq;
+        alignas(16) unsigned char data[DATA_SIZE];
+    };
+
+    static size_t RoundUp(size_t capacity) {
+        size_t size = 2;
+        while(size < capacity){
+            size <<= 1;
+        }
+        return size;
+    }
+
+    std::vector<slot> slots_;
+    const size_t mask_;
+
+    char pad0_[64];
+    std::atomic<size_t> enqueue_pos_;
+    char pad1_[64];
+    std::atomic<size_t> dequeue_pos_;
+    char pad2_[64];
+};
+
+} // namespace details
+} // namespace spdlog_json_config
+
+#endif // __SPDLOG_JSON_CONFIG_RECORD_RING_H__
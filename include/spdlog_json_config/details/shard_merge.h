@@ -0,0 +1,129 @@
+#ifndef __SPDLOG_JSON_CONFIG_SHARD_MERGE_H__
+#define __SPDLOG_JSON_CONFIG_SHARD_MERGE_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <memory>
+#include <queue>
+#include <string>
+#include <vector>
+
+
+namespace spdlog_json_config {
+namespace details {
+
+/**
+ * @brief  Merge of the shards of a sharded_file_sink into one file ordered by timestamp.
+ *
+ * The pattern must begin with a fixed width timestamp, most significant field first, e.g.
+ * "[%Y-%m-%d %H:%M:%S.%f]": the records are compared on the text up to the first ']', or
+ * on their first key_length characters. A line not beginning like the first line of its
+ * shard, e.g. the second line of a message, stays with the record before it. Each shard is
+ * in time order, they are merged with a heap; the records with the same timestamp are
+ * written in the order of the shards.
+ */
+class shard_merge {
+public:
+    explicit shard_merge(size_t key_length = 0) : key_length_(key_length) {}
+
+    /// @brief  Merge the files into out
+    ///
+    /// @return true if success, otherwise false and error is set
+    bool merge(const std::vector<std::string>& filenames, FILE* out, std::string& error){
+        std::vector<std::unique_ptr<cursor>> cursors;
+        std::priority_queue<cursor*, std::vector<cursor*>, later> heap;
+        for(size_t i = 0; i < filenames.size(); i++){
+            std::unique_ptr<cursor> current(new cursor(i));
+            current->file = fopen(filenames[i].c_str(), "r");
+            if(current->file == nullptr){
+                error = "open " + filenames[i] + ": " + strerror(errno);
+                return false;
+            }
+            if(ReadLine(*current)){
+                current->start = current->line[0];
+                if(ReadRecord(*current)){
+                    heap.push(current.get());
+                }
+            }
+            cursors.push_back(std::move(current));
+        }
+
+        while(!heap.empty()){
+            cursor* current = heap.top();
+            heap.pop();
+            if(fwrite(current->record.data(), 1, current->record.size(), out) != current->record.size()){
+                error = std::string("write: ") + strerror(errno);
+                return false;
+            }
+            if(ReadRecord(*current)){
+                heap.push(current);
+            }
+        }
+        return true;
+    }
+
+private:
+    struct cursor {
+        explicit cursor(size_t index)
+            : index(index), file(nullptr), start('\0'), has_line(false), buffer(nullptr), capacity(0) {}
+        ~cursor() {
+            if(file != nullptr) fclose(file);
+            free(buffer);
+        }
+
+        size_t          index;
+        FILE*           file;
+        char            start;      // first character of the records
+        std::string     key;
+        std::string     record;
+        std::string     line;       // line read ahead
+        bool            has_line;
+        char*           buffer;     // getline buffer
+        size_t          capacity;
+    };
+
+    struct later {
+        bool operator()(const cursor* a, const cursor* b) const {
+            int compare = a->key.compare(b->key);
+            return compare > 0 || (compare == 0 && a->index > b->index);
+        }
+    };
+
+    bool ReadLine(cursor& current){
+        ssize_t size = getline(&current.buffer, &current.capacity, current.file);
+        current.has_line = size > 0;
+        if(current.has_line){
+            current.line.assign(current.buffer, static_cast<size_t>(size));
+        }
+        return current.has_line;
+    }
+
+    /// Read the next record, the lines up to the next line beginning like a record
+    bool ReadRecord(cursor& current){
+        if(!current.has_line){
+            return false;
+        }
+        current.record.swap(current.line);
+        while(ReadLine(current) && current.line[0] != current.start){
+            current.record += current.line;
+        }
+
+        if(key_length_ > 0){
+            current.key = current.record.substr(0, key_length_);
+        }
+        else {
+            size_t end = current.record.find(']');
+            current.key = current.record.substr(0, end == std::string::npos ? current.record.size() : end + 1);
+        }
+        return true;
+    }
+
+    size_t key_length_;
+};
+
+} // namespace details
+} // namespace spdlog_json_config
+
+#endif // __SPDLOG_JSON_CONFIG_SHARD_MERGE_H__
@@ -0,0 +1,183 @@
+#ifndef __SPDLOG_JSON_CONFIG_URING_H__
+#define __SPDLOG_JSON_CONFIG_URING_H__
+
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+
+#include "spdlog/common.h"
+
+
+namespace spdlog_json_config {
+namespace details {
+
+/**
+ * @brief  Minimal io_uring submission/completion ring over the raw system calls.
+ *
+ * Only what the io_uring_file_sink needs: get a submission entry, submit, wait and peek
+ * completions, register buffers and files. Not thread safe: the owner serializes the calls.
+ */
+class uring {
+public:
+    /// @brief  Create a ring of entries submission entries
+    ///
+    /// Throw spdlog_ex if io_uring is not available, e.g. disabled by seccomp.
+    explicit uring(unsigned entries)
+        : fd_(-1), sq_ptr_(MAP_FAILED), cq_ptr_(MAP_FAILED), sq_size_(0), cq_size_(0),
+          sqes_(static_cast<struct io_uring_sqe*>(MAP_FAILED)), sqes_size_(0), sqe_tail_(0){
+        struct io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        fd_ = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+        if(fd_ < 0){
+            spdlog::throw_spdlog_ex("io_uring_setup failed", errno);
+        }
+
+        sq_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_size_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+        bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if(single_mmap){
+            sq_size_ = cq_size_ = (sq_size_ > cq_size_ ? sq_size_ : cq_size_);
+        }
+
+        sq_ptr_ = mmap(nullptr, sq_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                       fd_, IORING_OFF_SQ_RING);
+        if(sq_ptr_ != MAP_FAILED){
+            cq_ptr_ = single_mmap ? sq_ptr_ :
+                      mmap(nullptr, cq_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                           fd_, IORING_OFF_CQ_RING);
+        }
+        if(cq_ptr_ != MAP_FAILED){
+            sqes_ = static_cast<struct io_uring_sqe*>(
+                        mmap(nullptr, params.sq_entries * sizeof(struct io_uring_sqe),
+                             PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQES));
+        }
+        if(sqes_ == MAP_FAILED){
+            int err = errno;
+            Release();
+            spdlog::throw_spdlog_ex("io_uring mmap failed", err);
+        }
+        sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+
+        char* sq = static_cast<char*>(sq_ptr_);
+        sq_head_    = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        sq_tail_    = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sq_mask_    = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sq_entries_ = params.sq_entries;
+        sq_array_   = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+
+        char* cq = static_cast<char*>(cq_ptr_);
+        cq_head_    = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cq_tail_    = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cq_mask_    = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes_       = reinterpret_cast<struct io_uring_cqe*>(cq + params.cq_off.cqes);
+
+        sqe_tail_ = *sq_tail_;
+    }
+
+    ~uring(){
+        Release();
+    }
+
+    uring(const uring&) = delete;
+    uring& operator=(const uring&) = delete;
+
+    /// @return 0 on success, -errno on failure
+    int register_buffers(const struct iovec* iovecs, unsigned count){
+        return Register(IORING_REGISTER_BUFFERS, iovecs, count);
+    }
+
+    /// @return 0 on success, -errno on failure
+    int register_files(const int* fds, unsigned count){
+        return Register(IORING_REGISTER_FILES, fds, count);
+    }
+
+    /// @brief  Get a zeroed submission entry, queued by the next submit()
+    ///
+    /// @return nullptr if the submission queue is full
+    struct io_uring_sqe* get_sqe(){
+        unsigned head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+        if(sqe_tail_ - head >= sq_entries_){
+            return nullptr;
+        }
+        unsigned index = sqe_tail_ & sq_mask_;
+        struct io_uring_sqe* sqe = &sqes_[index];
+        memset(sqe, 0, sizeof(*sqe));
+        sq_array_[index] = index;
+        sqe_tail_++;
+        return sqe;
+    }
+
+    /// @brief  Submit the entries not consumed by the kernel yet, and wait for wait_count completions
+    ///
+    /// @return number of entries submitted, -errno on failure
+    int submit(unsigned wait_count){
+        __atomic_store_n(sq_tail_, sqe_tail_, __ATOMIC_RELEASE);
+        unsigned to_submit = sqe_tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+        if(to_submit == 0 && wait_count == 0){
+            return 0;
+        }
+
+        unsigned flags = wait_count > 0 ? IORING_ENTER_GETEVENTS : 0;
+        int ret;
+        do {
+            ret = static_cast<int>(syscall(__NR_io_uring_enter, fd_, to_submit, wait_count,
+                                           flags, nullptr, 0));
+        } while(ret < 0 && errno == EINTR);
+        return ret < 0 ? -errno : ret;
+    }
+
+    /// @brief  Pop a completion if any
+    ///
+    /// @return true if cqe was filled
+    bool peek_cqe(struct io_uring_cqe& cqe){
+        unsigned head = *cq_head_;
+        if(head == __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)){
+            return false;
+        }
+        cqe = cqes_[head & cq_mask_];
+        __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+
+private:
+    int Register(unsigned opcode, const void* arg, unsigned count){
+        int ret = static_cast<int>(syscall(__NR_io_uring_register, fd_, opcode, arg, count));
+        return ret < 0 ? -errno : ret;
+    }
+
+    void Release(){
+        if(sqes_ != MAP_FAILED) munmap(sqes_, sqes_size_);
+        if(cq_ptr_ != MAP_FAILED && cq_ptr_ != sq_ptr_) munmap(cq_ptr_, cq_size_);
+        if(sq_ptr_ != MAP_FAILED) munmap(sq_ptr_, sq_size_);
+        if(fd_ >= 0) ::close(fd_);
+    }
+
+    int                     fd_;
+    void*                   sq_ptr_;
+    void*                   cq_ptr_;
+    size_t                  sq_size_;
+    size_t                  cq_size_;
+    struct io_uring_sqe*    sqes_;
+    size_t                  sqes_size_;
+
+    unsigned*               sq_head_;
+    unsigned*               sq_tail_;
+    unsigned                sq_mask_;
+    unsigned                sq_entries_;
+    unsigned*               sq_array_;
+    unsigned                sqe_tail_;      // tail of the entries got, not yet submitted
+
+    unsigned*               cq_head_;
+    unsigned*               cq_tail_;
+    unsigned                cq_mask_;
+    struct io_uring_cqe*    cqes_;
+};
+
+} // namespace details
+} // namespace spdlog_json_config
+
+#endif // __SPDLOG_JSON_CONFIG_URING_H__
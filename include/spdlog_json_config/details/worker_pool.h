@@ -0,0 +1,332 @@
+#ifndef __SPDLOG_JSON_CONFIG_WORKER_POOL_H__
+#define __SPDLOG_JSON_CONFIG_WORKER_POOL_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "spdlog/common.h"
+
+
+namespace spdlog_json_config {
+namespace details {
+
+class worker_pool;
+
+/**
+ * @brief  A queue of records which must be processed in order, e.g. the queue of one logger.
+ *
+ * A lane is scheduled on the worker pool when it becomes non empty, and is processed by
+ * at most one worker at a time. Producers only touch the pool on the idle to busy
+ * transition of the lane, a busy lane costs them one atomic load.
+ */
+class async_lane : public std::enable_shared_from_this<async_lane> {
+public:
+    async_lane() : scheduled_(false), partition_(0) {}
+    virtual ~async_lane() {}
+
+    /// @brief  Set the worker which processes the lane in a partitioned pool
+    ///
+    /// @param  partition  worker index, see worker_pool::partition_of()
+    void set_partition(size_t partition) {
+        partition_ = partition;
+    }
+
+    size_t partition() const {
+        return partition_;
+    }
+
+    /// @brief  Process up to max_records records in order
+    ///
+    /// @return number of records processed
+    virtual size_t process(size_t max_records) = 0;
+
+    /// @brief  Whether there is no record to process
+    virtual bool empty() const = 0;
+
+    /// @brief  Approximate number of records to process
+    virtual size_t size() const = 0;
+
+protected:
+    /// @brief  Schedule the lane on the pool after records were queued, if not scheduled yet
+    inline void schedule(const std::weak_ptr<worker_pool>& pool);
+
+private:
+    friend class worker_pool;
+
+    /// @brief  Release the lane after processing
+    ///
+    /// @return true if records arrived meanwhile and the lane must be processed again
+    bool release() {
+        scheduled_.store(false, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        return !empty() && !scheduled_.exchange(true, std::memory_order_acq_rel);
+    }
+
+    std::atomic<bool> scheduled_;
+    size_t partition_;
+};
+
+/**
+ * @brief  Elastic pool of threads processing the scheduled async lanes.
+ *
+ * The pool runs between min_threads and max_threads workers. After a batch, a worker
+ * starts one more worker if no worker is idle and the records pending in the scheduled
+ * lanes exceed grow_threshold per running worker. A worker above min_threads retires
+ * after shrink_idle_ms without any lane to process.
+ * Since a lane is processed by one worker at a time, the number of workers never
+ * changes the order of the records of a lane.
+ *
+ * A partitioned pool instead runs a fixed number of workers, each with its own queue.
+ * Every lane is pinned to one worker, so lanes sharing a key (e.g. loggers writing the same
+ * sinks) never run concurrently and never contend on the sink mutexes.
+ *
+ * On destruction the workers keep processing until every scheduled lane is empty.
+ */
+class worker_pool {
+public:
+    const static size_t BATCH_SIZE = 256;   ///< records processed before a lane goes back to the queue
+
+    /// @brief  Fixed size pool
+    ///
+    /// @param  thread_count  number of workers
+    /// @param  partitioned   true to pin every lane to the worker of its partition
+    explicit worker_pool(size_t thread_count, bool partitioned = false)
+        : min_threads_(thread_count > 0 ? thread_count : 1), max_threads_(min_threads_),
+          grow_threshold_(0), shrink_idle_(0), partitioned_(partitioned),
+          active_(true), running_(0), idle_(0) {
+        Start();
+    }
+
+    /// @brief  Elastic pool
+    ///
+    /// @param  min_threads      workers always running, at least 1
+    /// @param  max_threads      max number of workers
+    /// @param  grow_threshold   pending records per running worker above which a worker is started
+    /// @param  shrink_idle_ms   idle time after which a worker above min_threads retires
+    worker_pool(size_t min_threads, size_t max_threads, size_t grow_threshold, uint32_t shrink_idle_ms)
+        : min_threads_(min_threads > 0 ? min_threads : 1),
+          max_threads_(max_threads > min_threads_ ? max_threads : min_threads_),
+          grow_threshold_(grow_threshold), shrink_idle_(shrink_idle_ms), partitioned_(false),
+          active_(true), running_(0), idle_(0) {
+        Start();
+    }
+
+    worker_pool(const worker_pool&) = delete;
+    worker_pool& operator=(const worker_pool&) = delete;
+
+    ~worker_pool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            active_ = false;
+        }
+        for(auto& cv : cvs_){
+            cv->notify_all();
+        }
+
+        // workers may retire or start until the last one exits
+        std::unique_lock<std::mutex> lock(mutex_);
+        while(running_ > 0){
+            exited_cv_.wait(lock);
+        }
+        std::vector<std::thread> threads;
+        threads.swap(threads_);
+        lock.unlock();
+        for(auto& t : threads){
+            if(t.joinable()){
+                t.join();
+            }
+        }
+    }
+
+    /// @brief  Queue a lane for processing
+    void schedule(std::shared_ptr<async_lane> lane) {
+        size_t queue = partitioned_ ? lane->partition() % ready_.size() : 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ready_[queue].push_back(std::move(lane));
+        }
+        cvs_[queue]->notify_one();
+    }
+
+    /// @brief  Worker of a partition key in a partitioned pool
+    ///
+    /// Keys are spread with a jump consistent hash, so a key keeps its worker across runs.
+    size_t partition_of(const std::string& key) const {
+        uint64_t hash = 14695981039346656037ULL;     // FNV-1a
+        for(char c : key){
+            hash = (hash ^ (unsigned char)c) * 1099511628211ULL;
+        }
+
+        int64_t bucket = -1;
+        int64_t next = 0;
+        while(next < (int64_t)min_threads_){
+            bucket = next;
+            hash = hash * 2862933555777941757ULL + 1;
+            next = (int64_t)((bucket + 1) * (double(1LL << 31) / double((hash >> 33) + 1)));
+        }
+        return (size_t)bucket;
+    }
+
+    bool partitioned() const {
+        return partitioned_;
+    }
+
+    /// @brief  Number of running workers
+    size_t thread_count() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return running_;
+    }
+
+    size_t min_threads() const {
+        return min_threads_;
+    }
+
+    size_t max_threads() const {
+        return max_threads_;
+    }
+
+private:
+    void Start() {
+        // one queue per worker if partitioned, otherwise one queue shared by all workers
+        size_t queue_count = partitioned_ ? min_threads_ : 1;
+        ready_.resize(queue_count);
+        for(size_t i = 0; i < queue_count; i++){
+            cvs_.emplace_back(new std::condition_variable());
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        for(size_t i = 0; i < min_threads_; i++){
+            StartWorkerLocked();
+        }
+    }
+
+    void StartWorkerLocked() {
+        size_t queue = partitioned_ ? running_ : 0;
+        running_++;
+        threads_.emplace_back(&worker_pool::Run, this, queue);
+    }
+
+    /// Pending records of the lanes waiting for a worker
+    size_t PendingLocked() const {
+        size_t pending = 0;
+        for(auto& lane : ready_[0]){
+            pending += lane->size();
+        }
+        return pending;
+    }
+
+    void GrowLocked(size_t pending) {
+        if(active_ && running_ < max_threads_ && idle_ == 0 && grow_threshold_ > 0 &&
+           pending > grow_threshold_ * running_){
+            StartWorkerLocked();
+        }
+    }
+
+    /// @param  queue  index of the queue the worker takes lanes from
+    void Run(size_t queue) {
+        std::deque<std::shared_ptr<async_lane>>& ready = ready_[queue];
+        std::condition_variable& cv = *cvs_[queue];
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        for(;;){
+            while(active_ && ready.empty()){
+                idle_++;
+                bool timeout = false;
+                if(running_ > min_threads_ && shrink_idle_.count() > 0){
+                    timeout = cv.wait_for(lock, shrink_idle_) == std::cv_status::timeout;
+                }
+                else {
+                    cv.wait(lock);
+                }
+                idle_--;
+
+                if(timeout && ready.empty() && running_ > min_threads_){
+                    Exit(true);
+                    return;
+                }
+            }
+            if(ready.empty()){
+                Exit(false);
+                return;
+            }
+
+            std::shared_ptr<async_lane> lane = std::move(ready.front());
+            ready.pop_front();
+            lock.unlock();
+
+            lane->process(BATCH_SIZE);
+            bool again = lane->release();
+
+            lock.lock();
+            if(again){
+                ready.push_back(lane);
+            }
+            if(!partitioned_){
+                GrowLocked(PendingLocked());
+            }
+        }
+    }
+
+    /// @brief  Called with the lock held by a worker about to exit
+    ///
+    /// @param  retire  true if the worker retires while the pool is active. It detaches
+    ///                 itself since a thread cannot join itself. Otherwise the pool is being
+    ///                 destroyed and joins it.
+    void Exit(bool retire) {
+        running_--;
+        if(retire){
+            std::thread::id self = std::this_thread::get_id();
+            for(size_t i = 0; i < threads_.size(); i++){
+                if(threads_[i].get_id() == self){
+                    threads_[i].detach();
+                    threads_.erase(threads_.begin() + i);
+                    break;
+                }
+            }
+        }
+        exited_cv_.notify_all();
+    }
+
+    const size_t min_threads_;
+    const size_t max_threads_;
+    const size_t grow_threshold_;
+    const std::chrono::milliseconds shrink_idle_;
+    const bool partitioned_;
+
+    bool active_;
+    size_t running_;
+    size_t idle_;
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<std::condition_variable>> cvs_;
+    std::condition_variable exited_cv_;
+    std::vector<std::deque<std::shared_ptr<async_lane>>> ready_;
+    std::vector<std::thread> threads_;
+};
+
+void async_lane::schedule(const std::weak_ptr<worker_pool>& pool) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if(scheduled_.load(std::memory_order_relaxed) || scheduled_.exchange(true, std::memory_order_acq_rel)){
+        return;
+    }
+
+    std::shared_ptr<worker_pool> pool_ptr = pool.lock();
+    if(pool_ptr == nullptr){
+        scheduled_.store(false, std::memory_order_relaxed);
+        throw spdlog::spdlog_ex("async log: worker pool doesn't exist anymore");
+    }
+    pool_ptr->schedule(shared_from_this());
+}
+
+} // namespace details
+} // namespace spdlog_json_config
+
+#endif // __SPDLOG_JSON_CONFIG_WORKER_POOL_H__
@@ -0,0 +1,58 @@
+#ifndef __SPDLOG_JSON_CONFIG_PLUGIN_H__
+#define __SPDLOG_JSON_CONFIG_PLUGIN_H__
+
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "rapidjson/document.h"
+#include "spdlog/sinks/sink.h"
+
+
+/// Name of the entry point of a plugin. The number is the version of the plugin
+/// interface: it changes with any incompatible change of this header.
+#define SPDLOG_JSON_CONFIG_PLUGIN_ENTRY         spdlog_json_config_plugin_register_v1
+#define SPDLOG_JSON_CONFIG_PLUGIN_ENTRY_NAME    "spdlog_json_config_plugin_register_v1"
+
+
+namespace spdlog_json_config {
+
+/// @brief  Factory of a sink type
+///
+/// Gets the name of the sink, its type and its configuration object of the SINKS
+/// section, returns the sink or nullptr on failure. The common settings of the sinks
+/// ("level", "pattern", "rate_limit", "dedup") are applied to the sink it returns.
+typedef std::function<std::shared_ptr<spdlog::sinks::sink>(const std::string& sink_name,
+                                                           const std::string& sink_type,
+                                                           const rapidjson::Value& value)> sink_factory;
+
+/**
+ * @brief  Registry of the sink types, given to the entry point of a plugin.
+ *
+ * A plugin is a shared library listed in the "PLUGINS" array of the configuration. It is
+ * loaded by Initialize() before the sinks are created, and defines the entry point:
+ *
+ *          extern "C" bool SPDLOG_JSON_CONFIG_PLUGIN_ENTRY(spdlog_json_config::plugin_registry* registry){
+ *              return registry->register_sink_type("fast_sink_mt", CreateFastSink);
+ *          }
+ *
+ * It returns false on failure. The objects cross the library boundary by value and by
+ * virtual call: the plugin must be built with the same spdlog, rapidjson and standard
+ * library as the application. A plugin is loaded once and never unloaded.
+ */
+class plugin_registry {
+public:
+    virtual ~plugin_registry() {}
+
+    /// @brief  Register the factory of a sink type
+    ///
+    /// @return false if the type is already registered
+    virtual bool register_sink_type(const std::string& sink_type, sink_factory factory) = 0;
+};
+
+/// Type of the entry point of a plugin
+typedef bool (*plugin_entry)(plugin_registry* registry);
+
+} // namespace spdlog_json_config
+
+#endif // __SPDLOG_JSON_CONFIG_PLUGIN_H__
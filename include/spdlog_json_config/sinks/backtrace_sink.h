@@ -0,0 +1,73 @@
+#ifndef __SPDLOG_JSON_CONFIG_BACKTRACE_SINK_H__
+#define __SPDLOG_JSON_CONFIG_BACKTRACE_SINK_H__
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+#include "spdlog/common.h"
+#include "spdlog/details/circular_q.h"
+#include "spdlog/details/log_msg_buffer.h"
+
+#include "proxy_sink.h"
+
+
+namespace spdlog_json_config {
+namespace sinks {
+
+/**
+ * @brief  Sink of a logger with a backtrace, in front of the sinks of the logger.
+ *
+ * The logger is left at level trace, and the level configured for the logger is moved
+ * here. The records below that level are not written: the last ones are kept in a ring,
+ * unformatted. When a record at or above the dump_on level comes, the records of the ring
+ * are written first, then the ring is emptied. The wrapped sink is the fanout_sink of the
+ * sinks of the logger, so the levels of the sinks still apply.
+ */
+class backtrace_sink : public proxy_sink {
+public:
+    backtrace_sink(std::shared_ptr<spdlog::sinks::sink> sink, spdlog::level::level_enum logger_level,
+                   size_t backtrace_size, spdlog::level::level_enum dump_on)
+        : proxy_sink(std::move(sink)), logger_level_(logger_level), dump_on_(dump_on), ring_(backtrace_size) {}
+
+    void log(const spdlog::details::log_msg& msg) override {
+        if(msg.level < logger_level_.load(std::memory_order_relaxed)){
+            std::lock_guard<std::mutex> lock(mutex_);
+            ring_.push_back(spdlog::details::log_msg_buffer(msg));
+            return;
+        }
+        if(msg.level >= dump_on_){
+            dump();
+        }
+        sink_->log(msg);
+    }
+
+    /// @brief  Write the records of the ring, then empty it
+    void dump() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        while(!ring_.empty()){
+            sink_->log(ring_.front());
+            ring_.pop_front();
+        }
+    }
+
+    /// @brief  Level of the logger, below which the records go to the ring
+    spdlog::level::level_enum logger_level() const {
+        return logger_level_.load(std::memory_order_relaxed);
+    }
+
+    void set_logger_level(spdlog::level::level_enum level) {
+        logger_level_.store(level, std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<spdlog::level::level_enum>                              logger_level_;
+    spdlog::level::level_enum                                           dump_on_;
+    std::mutex                                                          mutex_;
+    spdlog::details::circular_q<spdlog::details::log_msg_buffer>        ring_;
+};
+
+} // namespace sinks
+} // namespace spdlog_json_config
+
+#endif // __SPDLOG_JSON_CONFIG_BACKTRACE_SINK_H__
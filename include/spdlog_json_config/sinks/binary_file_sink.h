@@ -0,0 +1,83 @@
+#ifndef __SPDLOG_JSON_CONFIG_BINARY_FILE_SINK_H__
+#define __SPDLOG_JSON_CONFIG_BINARY_FILE_SINK_H__
+
+#include <string>
+#include <mutex>
+#include <unordered_map>
+
+#include "spdlog/sinks/base_sink.h"
+#include "spdlog/details/file_helper.h"
+#include "spdlog/details/null_mutex.h"
+
+#include "../details/binary_record.h"
+
+
+namespace spdlog_json_config {
+namespace sinks {
+
+/**
+ * @brief  File sink writing length prefixed binary records, see details/binary_record.h.
+ *
+ * A record holds the time, logger id, level, thread id and payload of the message: the
+ * pattern is not applied, the files are rendered later by tools/binary_log_decoder with
+ * any pattern. The logger ids are defined in the file by logger records.
+ */
+template<typename Mutex>
+class binary_file_sink : public spdlog::sinks::base_sink<Mutex> {
+public:
+    binary_file_sink(const spdlog::filename_t& filename, bool truncate) : last_logger_id_(-1) {
+        file_helper_.open(filename, truncate);
+        if(file_helper_.size() == 0){
+            buffer_.clear();
+            details::binary_record::append_header(buffer_);
+            file_helper_.write(buffer_);
+        }
+    }
+
+    const spdlog::filename_t& filename() const {
+        return file_helper_.filename();
+    }
+
+protected:
+    void sink_it_(const spdlog::details::log_msg& msg) override {
+        buffer_.clear();
+        // Most records come from the logger of the previous record
+        if(last_logger_id_ < 0 || msg.logger_name != spdlog::string_view_t(last_logger_name_)){
+            last_logger_name_.assign(msg.logger_name.data(), msg.logger_name.size());
+            std::unordered_map<std::string, uint32_t>::const_iterator it = logger_ids_.find(last_logger_name_);
+            if(it == logger_ids_.end()){
+                last_logger_id_ = static_cast<int64_t>(logger_ids_.size());
+                logger_ids_[last_logger_name_] = static_cast<uint32_t>(last_logger_id_);
+                details::binary_record::append_logger(buffer_, static_cast<uint32_t>(last_logger_id_), msg.logger_name);
+            }
+            else {
+                last_logger_id_ = it->second;
+            }
+        }
+        details::binary_record::append_log(buffer_, static_cast<uint32_t>(last_logger_id_), msg);
+        file_helper_.write(buffer_);
+    }
+
+    void flush_() override {
+        file_helper_.flush();
+    }
+
+    // The records are not formatted
+    void set_pattern_(const std::string&) override {}
+    void set_formatter_(std::unique_ptr<spdlog::formatter>) override {}
+
+private:
+    spdlog::details::file_helper                file_helper_;
+    spdlog::memory_buf_t                        buffer_;
+    std::unordered_map<std::string, uint32_t>   logger_ids_;
+    std::string                                 last_logger_name_;
+    int64_t                                     last_logger_id_;
+};
+
+using binary_file_sink_mt = binary_file_sink<std::mutex>;
+using binary_file_sink_st = binary_file_sink<spdlog::details::null_mutex>;
+
+} // namespace sinks
+} // namespace spdlog_json_config
+
+#endif // __SPDLOG_JSON_CONFIG_BINARY_FILE_SINK_H__
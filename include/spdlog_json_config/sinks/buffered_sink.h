@@ -0,0 +1,148 @@
+#ifndef __SPDLOG_JSON_CONFIG_BUFFERED_SINK_H__
+#define __SPDLOG_JSON_CONFIG_BUFFERED_SINK_H__
+
+#include <chrono>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "spdlog/pattern_formatter.h"
+#include "spdlog/details/os.h"
+
+#include "proxy_sink.h"
+
+
+namespace spdlog_json_config {
+namespace sinks {
+
+/**
+ * @brief  Sink which formats the records into its own buffer and writes them to the
+ *         wrapped file sink in chunks.
+ *
+ * A chunk is written when the buffer reaches buffer_size bytes, on flush (so flush_on
+ * still applies), and by the periodic flusher when its oldest record is older than the
+ * max delay. The wrapped sink writes each chunk as one record with a "%v" pattern and no
+ * eol, so a rotating file sink rotates between chunks. For a daily file sink, the buffer
+ * is written before the first record after the rotation time, so that every record goes
+ * to the file of its day.
+ */
+class buffered_sink : public proxy_sink {
+public:
+    buffered_sink(std::shared_ptr<spdlog::sinks::sink> sink, size_t buffer_size,
+                  std::chrono::milliseconds max_delay)
+        : proxy_sink(std::move(sink)), buffer_size_(buffer_size), max_delay_(max_delay),
+          formatter_(new spdlog::pattern_formatter()), max_level_(spdlog::level::trace),
+          daily_rotation_(false), rotation_hour_(0), rotation_minute_(0) {
+        buffer_.reserve(buffer_size_);
+        sink_->set_formatter(std::unique_ptr<spdlog::formatter>(
+            new spdlog::pattern_formatter("%v", spdlog::pattern_time_type::local, std::string())));
+    }
+
+    ~buffered_sink() override {
+        try{
+            std::lock_guard<std::mutex> lock(mutex_);
+            WriteBuffer();
+        }
+        catch(...){
+        }
+    }
+
+    /// @brief  Write the buffer before the first record after the daily rotation time
+    void set_daily_rotation(int rotation_hour, int rotation_minute) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        daily_rotation_ = true;
+        rotation_hour_ = rotation_hour;
+        rotation_minute_ = rotation_minute;
+    }
+
+    void log(const spdlog::details::log_msg& msg) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if(buffer_.size() > 0 && daily_rotation_ && msg.time >= rotation_time_){
+            WriteBuffer();
+        }
+        if(buffer_.size() == 0){
+            first_time_ = msg.time;
+            first_steady_ = std::chrono::steady_clock::now();
+            if(daily_rotation_) rotation_time_ = NextRotationTime(msg.time);
+        }
+
+        formatter_->format(msg, buffer_);
+        if(msg.level > max_level_) max_level_ = msg.level;
+        if(buffer_.size() >= buffer_size_){
+            WriteBuffer();
+        }
+    }
+
+    void flush() override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        WriteBuffer();
+        sink_->flush();
+    }
+
+    void set_pattern(const std::string& pattern) override {
+        set_formatter(std::unique_ptr<spdlog::formatter>(new spdlog::pattern_formatter(pattern)));
+    }
+
+    void set_formatter(std::unique_ptr<spdlog::formatter> sink_formatter) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        formatter_ = std::move(sink_formatter);
+    }
+
+    /// @brief  Write the buffer and flush the wrapped sink if the oldest record is older than the max delay
+    void write_if_expired(std::chrono::steady_clock::time_point now) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if(buffer_.size() > 0 && now - first_steady_ >= max_delay_){
+            WriteBuffer();
+            sink_->flush();
+        }
+    }
+
+    std::chrono::milliseconds max_delay() const {
+        return max_delay_;
+    }
+
+private:
+    void WriteBuffer() {
+        if(buffer_.size() == 0){
+            return;
+        }
+        spdlog::details::log_msg chunk(first_time_, spdlog::source_loc(), spdlog::string_view_t(),
+                                       max_level_, spdlog::string_view_t(buffer_.data(), buffer_.size()));
+        buffer_.clear();
+        max_level_ = spdlog::level::trace;
+        sink_->log(chunk);
+    }
+
+    /// Same rotation time as the daily_file_sink
+    spdlog::log_clock::time_point NextRotationTime(spdlog::log_clock::time_point time) const {
+        std::tm date = spdlog::details::os::localtime(spdlog::log_clock::to_time_t(time));
+        date.tm_hour = rotation_hour_;
+        date.tm_min = rotation_minute_;
+        date.tm_sec = 0;
+        spdlog::log_clock::time_point rotation_time = spdlog::log_clock::from_time_t(std::mktime(&date));
+        if(rotation_time > time){
+            return rotation_time;
+        }
+        return rotation_time + std::chrono::hours(24);
+    }
+
+    size_t                              buffer_size_;
+    std::chrono::milliseconds           max_delay_;
+    std::mutex                          mutex_;
+    std::unique_ptr<spdlog::formatter>  formatter_;
+    spdlog::memory_buf_t                buffer_;
+    spdlog::level::level_enum           max_level_;
+    spdlog::log_clock::time_point       first_time_;
+    std::chrono::steady_clock::time_point first_steady_;
+
+    bool                                daily_rotation_;
+    int                                 rotation_hour_;
+    int                                 rotation_minute_;
+    spdlog::log_clock::time_point       rotation_time_;
+};
+
+} // namespace sinks
+} // namespace spdlog_json_config
+
+#endif // __SPDLOG_JSON_CONFIG_BUFFERED_SINK_H__
@@ -0,0 +1,159 @@
+#ifndef __SPDLOG_JSON_CONFIG_COMPRESSED_FILE_SINK_H__
+#define __SPDLOG_JSON_CONFIG_COMPRESSED_FILE_SINK_H__
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <zlib.h>
+#ifdef SPDLOG_JSON_CONFIG_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+#include "spdlog/sinks/base_sink.h"
+#include "spdlog/details/null_mutex.h"
+
+#include "../details/background_compressor.h"
+
+
+namespace spdlog_json_config {
+namespace sinks {
+
+/**
+ * @brief  File sink compressing the records into independent frames.
+ *
+ * The records are formatted into a buffer of frame_size bytes. A full buffer, or the
+ * buffer on flush and close, is compressed into one frame, written with one write(2):
+ * a gzip member, or a zstd frame. Concatenated frames are a valid gzip or zstd stream,
+ * so the file is read with zcat/zstdcat, also while being written, and after a crash up
+ * to the last complete frame. Each flush ends a frame: a small frame compresses less.
+ *
+ * The compression runs in the thread writing the sink: use it with an async logger to
+ * compress in the worker threads.
+ */
+template<typename Mutex>
+class compressed_file_sink : public spdlog::sinks::base_sink<Mutex> {
+public:
+    compressed_file_sink(const spdlog::filename_t& filename, bool truncate, size_t frame_size,
+                         details::compress_format format, int level)
+        : filename_(filename), fd_(-1), frame_size_(frame_size), format_(format), level_(level){
+        if(frame_size_ == 0) frame_size_ = 64 * 1024;
+        buffer_.reserve(frame_size_);
+
+        int flags = O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC;
+        if(truncate) flags |= O_TRUNC;
+        fd_ = ::open(filename_.c_str(), flags, 0644);
+        if(fd_ < 0){
+            spdlog::throw_spdlog_ex("compressed_file_sink: failed opening file " + filename_, errno);
+        }
+    }
+
+    ~compressed_file_sink() override {
+        try{
+            WriteFrame();
+        }
+        catch(...){
+        }
+        ::close(fd_);
+    }
+
+    compressed_file_sink(const compressed_file_sink&) = delete;
+    compressed_file_sink& operator=(const compressed_file_sink&) = delete;
+
+    const spdlog::filename_t& filename() const {
+        return filename_;
+    }
+
+protected:
+    void sink_it_(const spdlog::details::log_msg& msg) override {
+        spdlog::sinks::base_sink<Mutex>::formatter_->format(msg, buffer_);
+        if(buffer_.size() >= frame_size_){
+            WriteFrame();
+        }
+    }
+
+    void flush_() override {
+        WriteFrame();
+    }
+
+private:
+    /// @brief  Compress the buffer into one frame and append it to the file
+    void WriteFrame(){
+        if(buffer_.size() == 0){
+            return;
+        }
+
+        if(format_ == details::compress_format::gzip){
+            CompressGzip();
+        }
+        else {
+            CompressZstd();
+        }
+        buffer_.clear();
+
+        const char* data = frame_.data();
+        size_t size = frame_.size();
+        while(size > 0){
+            ssize_t written = ::write(fd_, data, size);
+            if(written < 0){
+                if(errno == EINTR) continue;
+                spdlog::throw_spdlog_ex("compressed_file_sink: failed writing to " + filename_, errno);
+            }
+            data += written;
+            size -= static_cast<size_t>(written);
+        }
+    }
+
+    void CompressGzip(){
+        z_stream stream;
+        memset(&stream, 0, sizeof(stream));
+        // windowBits 15 + 16: gzip header and trailer, i.e. one gzip member
+        if(deflateInit2(&stream, level_, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK){
+            throw spdlog::spdlog_ex("compressed_file_sink: deflateInit2 failure");
+        }
+        frame_.resize(deflateBound(&stream, static_cast<uLong>(buffer_.size())));
+        stream.next_in   = reinterpret_cast<Bytef*>(buffer_.data());
+        stream.avail_in  = static_cast<uInt>(buffer_.size());
+        stream.next_out  = reinterpret_cast<Bytef*>(&frame_[0]);
+        stream.avail_out = static_cast<uInt>(frame_.size());
+        int ret = deflate(&stream, Z_FINISH);
+        frame_.resize(stream.total_out);
+        deflateEnd(&stream);
+        if(ret != Z_STREAM_END){
+            throw spdlog::spdlog_ex("compressed_file_sink: deflate failure");
+        }
+    }
+
+    void CompressZstd(){
+#ifdef SPDLOG_JSON_CONFIG_WITH_ZSTD
+        frame_.resize(ZSTD_compressBound(buffer_.size()));
+        size_t size = ZSTD_compress(&frame_[0], frame_.size(), buffer_.data(), buffer_.size(), level_);
+        if(ZSTD_isError(size)){
+            throw spdlog::spdlog_ex(std::string("compressed_file_sink: ") + ZSTD_getErrorName(size));
+        }
+        frame_.resize(size);
+#else
+        throw spdlog::spdlog_ex("compressed_file_sink: zstd not available");
+#endif
+    }
+
+    spdlog::filename_t          filename_;
+    int                         fd_;
+    size_t                      frame_size_;
+    details::compress_format    format_;
+    int                         level_;
+    spdlog::memory_buf_t        buffer_;    // records of the next frame
+    std::vector<char>           frame_;     // compressed frame
+};
+
+using compressed_file_sink_mt = compressed_file_sink<std::mutex>;
+using compressed_file_sink_st = compressed_file_sink<spdlog::details::null_mutex>;
+
+} // namespace sinks
+} // namespace spdlog_json_config
+
+#endif // __SPDLOG_JSON_CONFIG_COMPRESSED_FILE_SINK_H__
@@ -0,0 +1,104 @@
+#ifndef __SPDLOG_JSON_CONFIG_DEDUP_SINK_H__
+#define __SPDLOG_JSON_CONFIG_DEDUP_SINK_H__
+
+#include <stdint.h>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "proxy_sink.h"
+
+
+namespace spdlog_json_config {
+namespace sinks {
+
+/**
+ * @brief  Sink collapsing consecutive identical records.
+ *
+ * A record with the same level and payload as the previous one written, within window
+ * from it, is only counted. The payloads are compared by size and 64 bit FNV-1a hash, not
+ * by content. The count is written as "last message repeated N times" before the next
+ * different record, or once the window expired: on the next record or on flush, e.g. by
+ * the periodic flusher. A record identical after the window is written again.
+ */
+class dedup_sink : public proxy_sink {
+public:
+    dedup_sink(std::shared_ptr<spdlog::sinks::sink> sink, std::chrono::milliseconds window)
+        : proxy_sink(std::move(sink)), window_(window), has_last_(false), last_hash_(0), last_size_(0),
+          last_level_(spdlog::level::off), repeats_(0) {}
+
+    ~dedup_sink() override {
+        try{
+            std::lock_guard<std::mutex> lock(mutex_);
+            WriteRepeats();
+        }
+        catch(...){
+        }
+    }
+
+    void log(const spdlog::details::log_msg& msg) override {
+        uint64_t hash = Hash(msg.payload);
+        std::lock_guard<std::mutex> lock(mutex_);
+        bool same = has_last_ && hash == last_hash_ && msg.payload.size() == last_size_ && msg.level == last_level_;
+        if(same && msg.time - last_time_ < window_){
+            repeats_++;
+            return;
+        }
+
+        WriteRepeats();
+        sink_->log(msg);
+        has_last_ = true;
+        last_hash_ = hash;
+        last_size_ = msg.payload.size();
+        last_level_ = msg.level;
+        last_time_ = msg.time;
+        last_logger_name_.assign(msg.logger_name.data(), msg.logger_name.size());
+    }
+
+    void flush() override {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if(spdlog::log_clock::now() - last_time_ >= window_){
+                WriteRepeats();
+                has_last_ = false;
+            }
+        }
+        sink_->flush();
+    }
+
+private:
+    void WriteRepeats() {
+        if(repeats_ == 0){
+            return;
+        }
+        std::string text = "last message repeated " + std::to_string(repeats_) + " times";
+        repeats_ = 0;
+        spdlog::details::log_msg summary(last_logger_name_, last_level_, text);
+        sink_->log(summary);
+    }
+
+    static uint64_t Hash(spdlog::string_view_t payload) {
+        uint64_t hash = 14695981039346656037ULL;
+        for(size_t i = 0; i < payload.size(); i++){
+            hash ^= static_cast<unsigned char>(payload.data()[i]);
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+
+    std::chrono::milliseconds       window_;
+    std::mutex                      mutex_;
+    bool                            has_last_;
+    uint64_t                        last_hash_;
+    size_t                          last_size_;
+    spdlog::level::level_enum       last_level_;
+    spdlog::log_clock::time_point   last_time_;
+    std::string                     last_logger_name_;
+    uint64_t                        repeats_;
+};
+
+} // namespace sinks
+} // namespace spdlog_json_config
+
+#endif // __SPDLOG_JSON_CONFIG_DEDUP_SINK_H__
@@ -0,0 +1,246 @@
+#ifndef __SPDLOG_JSON_CONFIG_DIRECT_FILE_SINK_H__
+#define __SPDLOG_JSON_CONFIG_DIRECT_FILE_SINK_H__
+
+#include <string>
+#include <memory>
+#include <algorithm>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "spdlog/sinks/base_sink.h"
+#include "spdlog/details/null_mutex.h"
+
+
+namespace spdlog_json_config {
+namespace sinks {
+
+/**
+ * @brief  File sink writing through O_DIRECT, bypassing the page cache.
+ *
+ * The records are appended to two aligned buffers of buffer_size bytes: a full buffer is
+ * written by a writer thread while the records are appended to the other one. On flush
+ * and close, the partial block at the tail is padded with zeros to the alignment, written,
+ * and the file is truncated to the records written. The next records are appended to that
+ * block, which is written again.
+ *
+ * If the file system does not support O_DIRECT, the same writes go through the page cache.
+ */
+template<typename Mutex>
+class direct_file_sink : public spdlog::sinks::base_sink<Mutex> {
+public:
+    const static size_t ALIGNMENT = 4096;
+
+    direct_file_sink(const spdlog::filename_t& filename, bool truncate, size_t buffer_size)
+        : filename_(filename), fd_(-1), direct_(false), current_(0), fill_(0), offset_(0),
+          pending_(nullptr), pending_size_(0), pending_offset_(0), error_(0), stop_(false){
+        buffer_size_ = (buffer_size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+        if(buffer_size_ == 0) buffer_size_ = ALIGNMENT;
+        for(int i = 0; i < 2; i++){
+            void* buffer = nullptr;
+            if(posix_memalign(&buffer, ALIGNMENT, buffer_size_) != 0){
+                throw spdlog::spdlog_ex("direct_file_sink: failed allocating buffers");
+            }
+            buffers_[i].reset(static_cast<char*>(buffer));
+        }
+
+        int flags = O_RDWR | O_CREAT | O_CLOEXEC;
+        if(truncate) flags |= O_TRUNC;
+        fd_ = ::open(filename_.c_str(), flags, 0644);
+        if(fd_ < 0){
+            spdlog::throw_spdlog_ex("direct_file_sink: failed opening file " + filename_, errno);
+        }
+
+        // Continue the partial block at the tail, without the zeros of a padding not truncated
+        struct stat st;
+        if(fstat(fd_, &st) == 0 && st.st_size > 0){
+            size_t size = static_cast<size_t>(st.st_size);
+            fill_ = size % ALIGNMENT;
+            offset_ = size - fill_;
+            if(pread(fd_, buffers_[0].get(), fill_, static_cast<off_t>(offset_)) != static_cast<ssize_t>(fill_)){
+                int err = errno;
+                ::close(fd_);
+                spdlog::throw_spdlog_ex("direct_file_sink: failed reading tail of " + filename_, err);
+            }
+            while(fill_ > 0 && buffers_[0].get()[fill_ - 1] == '\0'){
+                fill_--;
+            }
+        }
+
+        int fd_flags = fcntl(fd_, F_GETFL);
+        direct_ = fd_flags >= 0 && fcntl(fd_, F_SETFL, fd_flags | O_DIRECT) == 0;
+
+        writer_ = std::thread([this](){ Run(); });
+    }
+
+    ~direct_file_sink() override {
+        try{
+            WaitWrite();
+            WriteTail();
+        }
+        catch(...){
+        }
+        {
+            std::lock_guard<std::mutex> lock(writer_mutex_);
+            stop_ = true;
+        }
+        writer_cv_.notify_all();
+        writer_.join();
+        ::close(fd_);
+    }
+
+    direct_file_sink(const direct_file_sink&) = delete;
+    direct_file_sink& operator=(const direct_file_sink&) = delete;
+
+    const spdlog::filename_t& filename() const {
+        return filename_;
+    }
+
+    /// @brief  Whether the file is written with O_DIRECT, or through the page cache
+    bool direct() const {
+        return direct_;
+    }
+
+protected:
+    void sink_it_(const spdlog::details::log_msg& msg) override {
+        spdlog::memory_buf_t formatted;
+        spdlog::sinks::base_sink<Mutex>::formatter_->format(msg, formatted);
+
+        const char* data = formatted.data();
+        size_t size = formatted.size();
+        while(size > 0){
+            size_t count = std::min(size, buffer_size_ - fill_);
+            memcpy(buffers_[current_].get() + fill_, data, count);
+            fill_ += count;
+            data += count;
+            size -= count;
+            if(fill_ == buffer_size_){
+                WriteFull();
+            }
+        }
+    }
+
+    void flush_() override {
+        WaitWrite();
+        WriteTail();
+    }
+
+private:
+    struct free_deleter {
+        void operator()(char* buffer) const { free(buffer); }
+    };
+
+    /// @brief  Hand the full buffer to the writer thread and switch to the other one
+    void WriteFull(){
+        WaitWrite();
+        {
+            std::lock_guard<std::mutex> lock(writer_mutex_);
+            pending_ = buffers_[current_].get();
+            pending_size_ = buffer_size_;
+            pending_offset_ = offset_;
+        }
+        writer_cv_.notify_all();
+
+        offset_ += buffer_size_;
+        current_ ^= 1;
+        fill_ = 0;
+    }
+
+    /// @brief  Wait for the writer thread to write the pending buffer
+    void WaitWrite(){
+        std::unique_lock<std::mutex> lock(writer_mutex_);
+        writer_cv_.wait(lock, [this](){ return pending_ == nullptr; });
+        if(error_ != 0){
+            int err = error_;
+            error_ = 0;
+            spdlog::throw_spdlog_ex("direct_file_sink: failed writing to " + filename_, err);
+        }
+    }
+
+    /// @brief  Write the partial block at the tail padded with zeros, and truncate the padding
+    void WriteTail(){
+        if(fill_ == 0){
+            return;
+        }
+        size_t padded = (fill_ + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+        memset(buffers_[current_].get() + fill_, 0, padded - fill_);
+        int err = Write(buffers_[current_].get(), padded, offset_);
+        if(err == 0 && ftruncate(fd_, static_cast<off_t>(offset_ + fill_)) != 0){
+            err = errno;
+        }
+        if(err != 0){
+            spdlog::throw_spdlog_ex("direct_file_sink: failed writing to " + filename_, err);
+        }
+    }
+
+    /// @return 0 on success, errno on failure
+    int Write(const char* data, size_t size, size_t offset){
+        while(size > 0){
+            ssize_t written = pwrite(fd_, data, size, static_cast<off_t>(offset));
+            if(written < 0){
+                if(errno == EINTR) continue;
+                return errno;
+            }
+            // No progress, e.g. a full disk
+            if(written == 0) return ENOSPC;
+            data += written;
+            size -= static_cast<size_t>(written);
+            offset += static_cast<size_t>(written);
+        }
+        return 0;
+    }
+
+    void Run(){
+        std::unique_lock<std::mutex> lock(writer_mutex_);
+        for(;;){
+            writer_cv_.wait(lock, [this](){ return pending_ != nullptr || stop_; });
+            if(pending_ == nullptr){
+                return;
+            }
+
+            const char* data = pending_;
+            size_t size = pending_size_;
+            size_t offset = pending_offset_;
+            lock.unlock();
+            int err = Write(data, size, offset);
+            lock.lock();
+
+            if(err != 0) error_ = err;
+            pending_ = nullptr;
+            writer_cv_.notify_all();
+        }
+    }
+
+    spdlog::filename_t                      filename_;
+    int                                     fd_;
+    bool                                    direct_;
+    size_t                                  buffer_size_;
+    std::unique_ptr<char, free_deleter>     buffers_[2];
+    int                                     current_;       // buffer the records are appended to
+    size_t                                  fill_;          // bytes of records in the current buffer
+    size_t                                  offset_;        // file offset of the current buffer
+
+    // buffer handed to the writer thread
+    std::thread                             writer_;
+    std::mutex                              writer_mutex_;
+    std::condition_variable                 writer_cv_;
+    const char*                             pending_;
+    size_t                                  pending_size_;
+    size_t                                  pending_offset_;
+    int                                     error_;
+    bool                                    stop_;
+};
+
+using direct_file_sink_mt = direct_file_sink<std::mutex>;
+using direct_file_sink_st = direct_file_sink<spdlog::details::null_mutex>;
+
+} // namespace sinks
+} // namespace spdlog_json_config
+
+#endif // __SPDLOG_JSON_CONFIG_DIRECT_FILE_SINK_H__
@@ -0,0 +1,55 @@
+#ifndef __SPDLOG_JSON_CONFIG_DIRTY_TRACKING_SINK_H__
+#define __SPDLOG_JSON_CONFIG_DIRTY_TRACKING_SINK_H__
+
+#include <atomic>
+#include <memory>
+
+#include "proxy_sink.h"
+
+
+namespace spdlog_json_config {
+namespace sinks {
+
+/**
+ * @brief  Sink which remembers whether it was written since the last flush.
+ *
+ * Used by the periodic flusher to flush only the sinks which actually received records.
+ * The flag is only stored when it changes, so busy sinks do not bounce the cache line
+ * between the writing threads.
+ */
+class dirty_tracking_sink : public proxy_sink {
+public:
+    explicit dirty_tracking_sink(std::shared_ptr<spdlog::sinks::sink> sink)
+        : proxy_sink(std::move(sink)), dirty_(false) {}
+
+    void log(const spdlog::details::log_msg& msg) override {
+        sink_->log(msg);
+        if(!dirty_.load(std::memory_order_relaxed)){
+            dirty_.store(true, std::memory_order_release);
+        }
+    }
+
+    void flush() override {
+        dirty_.store(false, std::memory_order_relaxed);
+        sink_->flush();
+    }
+
+    /// @brief  Flush the wrapped sink if it was written since the last flush
+    ///
+    /// @return true if the sink was flushed
+    bool flush_if_dirty() {
+        if(!dirty_.load(std::memory_order_acquire)){
+            return false;
+        }
+        flush();
+        return true;
+    }
+
+private:
+    std::atomic<bool> dirty_;
+};
+
+} // namespace sinks
+} // namespace spdlog_json_config
+
+#endif // __SPDLOG_JSON_CONFIG_DIRTY_TRACKING_SINK_H__
@@ -0,0 +1,66 @@
+#ifndef __SPDLOG_JSON_CONFIG_FADVISE_SINK_H__
+#define __SPDLOG_JSON_CONFIG_FADVISE_SINK_H__
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "proxy_sink.h"
+
+
+namespace spdlog_json_config {
+namespace sinks {
+
+/**
+ * @brief  Sink which drops the pages of a buffered file sink from the page cache on flush.
+ *
+ * After the wrapped sink is flushed, the write back of the file is started, and the pages
+ * already written back are dropped with posix_fadvise(POSIX_FADV_DONTNEED). The pages
+ * still being written back are dropped by the next flush. The file name is got from the
+ * wrapped sink on every flush, so that rotated files are followed.
+ */
+class fadvise_sink : public proxy_sink {
+public:
+    fadvise_sink(std::shared_ptr<spdlog::sinks::sink> sink, std::function<std::string()> filename)
+        : proxy_sink(std::move(sink)), filename_(std::move(filename)), fd_(-1) {}
+
+    ~fadvise_sink() override {
+        if(fd_ >= 0){
+            ::close(fd_);
+        }
+    }
+
+    void flush() override {
+        sink_->flush();
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::string filename = filename_();
+        if(filename != current_filename_ || fd_ < 0){
+            if(fd_ >= 0){
+                // The file was rotated: drop the pages of the previous one
+                posix_fadvise(fd_, 0, 0, POSIX_FADV_DONTNEED);
+                ::close(fd_);
+            }
+            current_filename_ = filename;
+            fd_ = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+        }
+        if(fd_ >= 0){
+            sync_file_range(fd_, 0, 0, SYNC_FILE_RANGE_WRITE);
+            posix_fadvise(fd_, 0, 0, POSIX_FADV_DONTNEED);
+        }
+    }
+
+private:
+    std::function<std::string()>    filename_;
+    std::mutex                      mutex_;
+    std::string                     current_filename_;
+    int                             fd_;
+};
+
+} // namespace sinks
+} // namespace spdlog_json_config
+
+#endif // __SPDLOG_JSON_CONFIG_FADVISE_SINK_H__
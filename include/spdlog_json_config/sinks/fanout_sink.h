@@ -0,0 +1,70 @@
+#ifndef __SPDLOG_JSON_CONFIG_FANOUT_SINK_H__
+#define __SPDLOG_JSON_CONFIG_FANOUT_SINK_H__
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "spdlog/sinks/sink.h"
+#include "spdlog/formatter.h"
+
+
+namespace spdlog_json_config {
+namespace sinks {
+
+/**
+ * @brief  Sink writing each record to the sinks of a logger, as the logger does.
+ *
+ * Used as the wrapped sink of the proxy sinks applied to a whole logger, e.g. backtrace
+ * and rate limit. It has no lock: the levels of the sinks are checked, and each sink
+ * locks itself, as with the logger.
+ */
+class fanout_sink : public spdlog::sinks::sink {
+public:
+    explicit fanout_sink(std::vector<std::shared_ptr<spdlog::sinks::sink>> sinks)
+        : sinks_(std::move(sinks)) {}
+
+    void log(const spdlog::details::log_msg& msg) override {
+        for(auto& sink : sinks_){
+            if(sink->should_log(msg.level)){
+                sink->log(msg);
+            }
+        }
+    }
+
+    void flush() override {
+        for(auto& sink : sinks_){
+            sink->flush();
+        }
+    }
+
+    void set_pattern(const std::string& pattern) override {
+        for(auto& sink : sinks_){
+            sink->set_pattern(pattern);
+        }
+    }
+
+    void set_formatter(std::unique_ptr<spdlog::formatter> sink_formatter) override {
+        for(size_t i = 0; i < sinks_.size(); i++){
+            if(i + 1 == sinks_.size()){
+                sinks_[i]->set_formatter(std::move(sink_formatter));
+            }
+            else {
+                sinks_[i]->set_formatter(sink_formatter->clone());
+            }
+        }
+    }
+
+    /// @brief  Get the sinks of the logger
+    const std::vector<std::shared_ptr<spdlog::sinks::sink>>& sinks() const {
+        return sinks_;
+    }
+
+private:
+    std::vector<std::shared_ptr<spdlog::sinks::sink>> sinks_;
+};
+
+} // namespace sinks
+} // namespace spdlog_json_config
+
+#endif // __SPDLOG_JSON_CONFIG_FANOUT_SINK_H__
@@ -0,0 +1,139 @@
+#ifndef __SPDLOG_JSON_CONFIG_FLIGHT_RECORDER_SINK_H__
+#define __SPDLOG_JSON_CONFIG_FLIGHT_RECORDER_SINK_H__
+
+#include <string>
+#include <mutex>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "spdlog/sinks/base_sink.h"
+#include "spdlog/details/null_mutex.h"
+
+#include "../details/flight_recorder.h"
+
+
+namespace spdlog_json_config {
+namespace sinks {
+
+/**
+ * @brief  Sink writing the formatted records into a ring of a shared memory mapped file.
+ *
+ * The ring keeps the last ring_size bytes of records, e.g. full debug logs, in memory:
+ * nothing is written to the disk if the file is on tmpfs (/dev/shm). The pages belong to
+ * the file, so the records survive a crash or a SIGKILL of the process, and are recovered
+ * with tools/flight_recorder_dump. Each record has a sequence number and a checksum, see
+ * details/flight_recorder.h. An existing file of the same size is continued, so that the
+ * records of a previous process are kept until overwritten.
+ */
+template<typename Mutex>
+class flight_recorder_sink : public spdlog::sinks::base_sink<Mutex> {
+public:
+    flight_recorder_sink(const spdlog::filename_t& filename, size_t ring_size, bool truncate)
+        : filename_(filename), base_(nullptr), header_(nullptr), ring_(nullptr) {
+        capacity_ = (ring_size + details::flight_recorder::ALIGNMENT - 1) /
+                    details::flight_recorder::ALIGNMENT * details::flight_recorder::ALIGNMENT;
+        if(capacity_ < 4 * details::flight_recorder::aligned_size(0)){
+            spdlog::throw_spdlog_ex("flight_recorder_sink: ring size too small for " + filename_);
+        }
+        mapped_size_ = details::flight_recorder::HEADER_SIZE + capacity_;
+
+        int fd = ::open(filename_.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if(fd < 0){
+            spdlog::throw_spdlog_ex("flight_recorder_sink: failed opening file " + filename_, errno);
+        }
+        struct stat st;
+        bool reuse = !truncate && fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) == mapped_size_;
+        if(!reuse && (ftruncate(fd, 0) != 0 || ftruncate(fd, static_cast<off_t>(mapped_size_)) != 0)){
+            int err = errno;
+            ::close(fd);
+            spdlog::throw_spdlog_ex("flight_recorder_sink: failed sizing file " + filename_, err);
+        }
+        void* mapping = mmap(nullptr, mapped_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        int err = errno;
+        ::close(fd);
+        if(mapping == MAP_FAILED){
+            spdlog::throw_spdlog_ex("flight_recorder_sink: failed mapping file " + filename_, err);
+        }
+        base_ = static_cast<char*>(mapping);
+        header_ = reinterpret_cast<details::flight_recorder::file_header*>(base_);
+        ring_ = base_ + details::flight_recorder::HEADER_SIZE;
+
+        if(!reuse || memcmp(header_->magic, details::flight_recorder::MAGIC, sizeof(header_->magic)) != 0 ||
+           header_->version != details::flight_recorder::VERSION || header_->capacity != capacity_ ||
+           header_->write_offset > capacity_ || header_->write_offset % details::flight_recorder::ALIGNMENT != 0){
+            memset(base_, 0, mapped_size_);
+            memcpy(header_->magic, details::flight_recorder::MAGIC, sizeof(header_->magic));
+            header_->version = details::flight_recorder::VERSION;
+            header_->capacity = capacity_;
+            header_->write_offset = 0;
+            header_->next_seq = 0;
+        }
+    }
+
+    ~flight_recorder_sink() override {
+        if(base_ != nullptr){
+            munmap(base_, mapped_size_);
+        }
+    }
+
+    flight_recorder_sink(const flight_recorder_sink&) = delete;
+    flight_recorder_sink& operator=(const flight_recorder_sink&) = delete;
+
+    const spdlog::filename_t& filename() const {
+        return filename_;
+    }
+
+protected:
+    void sink_it_(const spdlog::details::log_msg& msg) override {
+        formatted_.clear();
+        spdlog::sinks::base_sink<Mutex>::formatter_->format(msg, formatted_);
+
+        // A record takes at most a quarter of the ring
+        size_t size = formatted_.size();
+        size_t max_size = capacity_ / 4 - sizeof(details::flight_recorder::record_header);
+        if(size > max_size) size = max_size;
+
+        size_t record_size = details::flight_recorder::aligned_size(size);
+        size_t offset = static_cast<size_t>(header_->write_offset);
+        if(offset + record_size > capacity_){
+            memset(ring_ + offset, 0, capacity_ - offset);
+            offset = 0;
+        }
+
+        details::flight_recorder::record_header rec;
+        rec.magic = details::flight_recorder::RECORD_MAGIC;
+        rec.size  = static_cast<uint32_t>(size);
+        rec.seq   = header_->next_seq;
+        rec.crc   = details::flight_recorder::checksum(rec.seq, formatted_.data(), size);
+        rec.level = static_cast<uint32_t>(msg.level);
+        memcpy(ring_ + offset, &rec, sizeof(rec));
+        memcpy(ring_ + offset + sizeof(rec), formatted_.data(), size);
+
+        header_->write_offset = offset + record_size;
+        header_->next_seq = rec.seq + 1;
+    }
+
+    // The records are in the page cache as soon as written
+    void flush_() override {}
+
+private:
+    spdlog::filename_t                          filename_;
+    size_t                                      capacity_;
+    size_t                                      mapped_size_;
+    char*                                       base_;
+    details::flight_recorder::file_header*      header_;
+    char*                                       ring_;
+    spdlog::memory_buf_t                        formatted_;
+};
+
+using flight_recorder_sink_mt = flight_recorder_sink<std::mutex>;
+using flight_recorder_sink_st = flight_recorder_sink<spdlog::details::null_mutex>;
+
+} // namespace sinks
+} // namespace spdlog_json_config
+
+#endif // __SPDLOG_JSON_CONFIG_FLIGHT_RECORDER_SINK_H__
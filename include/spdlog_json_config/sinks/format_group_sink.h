@@ -0,0 +1,77 @@
+#ifndef __SPDLOG_JSON_CONFIG_FORMAT_GROUP_SINK_H__
+#define __SPDLOG_JSON_CONFIG_FORMAT_GROUP_SINK_H__
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "spdlog/pattern_formatter.h"
+
+#include "fanout_sink.h"
+
+
+namespace spdlog_json_config {
+namespace sinks {
+
+/**
+ * @brief  Sink formatting each record once for the sinks of a logger sharing a pattern.
+ *
+ * The sinks of the group are set to a "%v" pattern without eol: the record is formatted
+ * here with the pattern they share, and the formatted text is written by each sink as the
+ * payload of a copy of the record. The time, level and logger name are kept, so the sinks
+ * rotating by time or size, or storing the level, behave the same. The formatter is not
+ * thread safe: it is locked while formatting only, not while the sinks write.
+ *
+ * A grouped sink must get preformatted records from all its loggers, so the grouping is
+ * decided per sink at initialization.
+ */
+class format_group_sink : public fanout_sink {
+public:
+    format_group_sink(std::vector<std::shared_ptr<spdlog::sinks::sink>> sinks,
+                      std::unique_ptr<spdlog::formatter> formatter)
+        : fanout_sink(std::move(sinks)), formatter_(std::move(formatter)) {
+        for(auto& sink : this->sinks()){
+            sink->set_formatter(std::unique_ptr<spdlog::formatter>(
+                new spdlog::pattern_formatter("%v", spdlog::pattern_time_type::local, std::string())));
+        }
+    }
+
+    void log(const spdlog::details::log_msg& msg) override {
+        bool wanted = false;
+        for(auto& sink : sinks()){
+            wanted = wanted || sink->should_log(msg.level);
+        }
+        if(!wanted){
+            return;
+        }
+
+        spdlog::memory_buf_t formatted;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            formatter_->format(msg, formatted);
+        }
+        spdlog::details::log_msg formatted_msg(msg.time, msg.source, msg.logger_name, msg.level,
+                                               spdlog::string_view_t(formatted.data(), formatted.size()));
+        formatted_msg.thread_id = msg.thread_id;
+        fanout_sink::log(formatted_msg);
+    }
+
+    void set_pattern(const std::string& pattern) override {
+        set_formatter(std::unique_ptr<spdlog::formatter>(new spdlog::pattern_formatter(pattern)));
+    }
+
+    void set_formatter(std::unique_ptr<spdlog::formatter> sink_formatter) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        formatter_ = std::move(sink_formatter);
+    }
+
+private:
+    std::mutex                          mutex_;
+    std::unique_ptr<spdlog::formatter>  formatter_;
+};
+
+} // namespace sinks
+} // namespace spdlog_json_config
+
+#endif // __SPDLOG_JSON_CONFIG_FORMAT_GROUP_SINK_H__
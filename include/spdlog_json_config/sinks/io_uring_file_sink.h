@@ -0,0 +1,267 @@
+#ifndef __SPDLOG_JSON_CONFIG_IO_URING_FILE_SINK_H__
+#define __SPDLOG_JSON_CONFIG_IO_URING_FILE_SINK_H__
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/uio.h>
+
+#include "spdlog/sinks/base_sink.h"
+#include "spdlog/details/null_mutex.h"
+
+#include "../details/uring.h"
+
+
+namespace spdlog_json_config {
+namespace sinks {
+
+/**
+ * @brief  File sink submitting its writes to an io_uring.
+ *
+ * The records are appended to one of queue_depth buffers of buffer_size bytes. A full
+ * buffer is submitted as one write at its file offset, and the next free buffer is used
+ * while the kernel writes it, so the logging thread only waits when all the buffers are
+ * in flight. The buffers and the file are registered to the ring. The completions are
+ * reaped in batches when a buffer is needed, and all of them on flush.
+ *
+ * If io_uring is not available, e.g. disabled by seccomp, the buffers are written with
+ * pwrite(2) by the logging thread.
+ */
+template<typename Mutex>
+class io_uring_file_sink : public spdlog::sinks::base_sink<Mutex> {
+public:
+    io_uring_file_sink(const spdlog::filename_t& filename, bool truncate,
+                       unsigned queue_depth, size_t buffer_size)
+        : filename_(filename), fd_(-1), offset_(0), buffer_size_(buffer_size),
+          current_(0), in_flight_(0), fixed_buffers_(false), error_(0){
+        if(queue_depth == 0) queue_depth = 1;
+        if(buffer_size_ == 0) buffer_size_ = 4096;
+
+        int flags = O_WRONLY | O_CREAT | O_CLOEXEC;
+        if(truncate) flags |= O_TRUNC;
+        fd_ = ::open(filename_.c_str(), flags, 0644);
+        if(fd_ < 0){
+            spdlog::throw_spdlog_ex("io_uring_file_sink: failed opening file " + filename_, errno);
+        }
+        off_t end = lseek(fd_, 0, SEEK_END);
+        offset_ = end > 0 ? static_cast<size_t>(end) : 0;
+
+        buffers_.resize(queue_depth);
+        std::vector<struct iovec> iovecs(queue_depth);
+        for(unsigned i = 0; i < queue_depth; i++){
+            buffers_[i].data.reset(new char[buffer_size_]);
+            iovecs[i].iov_base = buffers_[i].data.get();
+            iovecs[i].iov_len  = buffer_size_;
+        }
+
+        try{
+            ring_.reset(new details::uring(queue_depth));
+        }
+        catch(const spdlog::spdlog_ex&){
+            ring_.reset();
+        }
+        if(ring_ != nullptr){
+            if(ring_->register_files(&fd_, 1) != 0){
+                ring_.reset();
+            }
+            else {
+                // Registered buffers are charged to RLIMIT_MEMLOCK on old kernels: optional
+                fixed_buffers_ = ring_->register_buffers(iovecs.data(), queue_depth) == 0;
+            }
+        }
+    }
+
+    ~io_uring_file_sink() override {
+        try{
+            Submit();
+            WaitAll();
+        }
+        catch(...){
+        }
+        ring_.reset();
+        if(fd_ >= 0){
+            ::close(fd_);
+        }
+    }
+
+    io_uring_file_sink(const io_uring_file_sink&) = delete;
+    io_uring_file_sink& operator=(const io_uring_file_sink&) = delete;
+
+    const spdlog::filename_t& filename() const {
+        return filename_;
+    }
+
+    /// @brief  Whether the writes are submitted to an io_uring, or written with pwrite(2)
+    bool uses_io_uring() const {
+        return ring_ != nullptr;
+    }
+
+protected:
+    void sink_it_(const spdlog::details::log_msg& msg) override {
+        spdlog::memory_buf_t formatted;
+        spdlog::sinks::base_sink<Mutex>::formatter_->format(msg, formatted);
+
+        if(buffers_[current_].size + formatted.size() > buffer_size_){
+            Submit();
+        }
+        if(formatted.size() > buffer_size_){
+            // Larger than a buffer: write it as is, behind the buffers already submitted
+            int err = Write(formatted.data(), formatted.size(), offset_);
+            if(err != 0){
+                spdlog::throw_spdlog_ex("io_uring_file_sink: failed writing to " + filename_, err);
+            }
+            offset_ += formatted.size();
+            return;
+        }
+
+        buffer& current = buffers_[current_];
+        memcpy(current.data.get() + current.size, formatted.data(), formatted.size());
+        current.size += formatted.size();
+    }
+
+    void flush_() override {
+        Submit();
+        WaitAll();
+    }
+
+private:
+    struct buffer {
+        std::unique_ptr<char[]> data;
+        size_t                  size = 0;       // bytes of records in the buffer
+        size_t                  offset = 0;     // file offset of the write in flight
+        bool                    in_flight = false;
+    };
+
+    /// @brief  Submit the current buffer and switch to a free one
+    void Submit(){
+        buffer& current = buffers_[current_];
+        if(current.size == 0){
+            return;
+        }
+        current.offset = offset_;
+        offset_ += current.size;
+
+        if(ring_ == nullptr){
+            int err = Write(current.data.get(), current.size, current.offset);
+            current.size = 0;
+            if(err != 0){
+                spdlog::throw_spdlog_ex("io_uring_file_sink: failed writing to " + filename_, err);
+            }
+            return;
+        }
+
+        struct io_uring_sqe* sqe = ring_->get_sqe();
+        while(sqe == nullptr){
+            Reap(1);
+            sqe = ring_->get_sqe();
+        }
+        sqe->opcode    = fixed_buffers_ ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+        sqe->flags     = IOSQE_FIXED_FILE;
+        sqe->fd        = 0;     // index of the registered file
+        sqe->addr      = reinterpret_cast<uint64_t>(current.data.get());
+        sqe->len       = static_cast<uint32_t>(current.size);
+        sqe->off       = current.offset;
+        sqe->buf_index = static_cast<uint16_t>(current_);
+        sqe->user_data = current_;
+        current.in_flight = true;
+        in_flight_++;
+
+        int ret = ring_->submit(0);
+        if(ret < 0){
+            spdlog::throw_spdlog_ex("io_uring_file_sink: failed submitting write to " + filename_, -ret);
+        }
+
+        // Switch to the next free buffer, reaping the completions while none is free
+        Reap(0);
+        for(;;){
+            for(size_t i = 0; i < buffers_.size(); i++){
+                if(!buffers_[i].in_flight){
+                    current_ = i;
+                    return;
+                }
+            }
+            Reap(1);
+        }
+    }
+
+    /// @brief  Reap the completions, waiting for wait_count of them
+    void Reap(unsigned wait_count){
+        if(wait_count > 0){
+            int ret = ring_->submit(wait_count);
+            if(ret < 0){
+                spdlog::throw_spdlog_ex("io_uring_file_sink: failed waiting writes to " + filename_, -ret);
+            }
+        }
+
+        struct io_uring_cqe cqe;
+        while(ring_->peek_cqe(cqe)){
+            buffer& done = buffers_[cqe.user_data];
+            if(cqe.res < 0){
+                error_ = -cqe.res;
+            }
+            else if(static_cast<size_t>(cqe.res) < done.size){
+                // Short write: write the rest synchronously
+                int err = Write(done.data.get() + cqe.res, done.size - cqe.res, done.offset + cqe.res);
+                if(err != 0){
+                    error_ = err;
+                }
+            }
+            done.size = 0;
+            done.in_flight = false;
+            in_flight_--;
+        }
+
+        if(error_ != 0){
+            int err = error_;
+            error_ = 0;
+            spdlog::throw_spdlog_ex("io_uring_file_sink: failed writing to " + filename_, err);
+        }
+    }
+
+    void WaitAll(){
+        while(ring_ != nullptr && in_flight_ > 0){
+            Reap(in_flight_);
+        }
+    }
+
+    /// @return 0 on success, errno on failure
+    int Write(const char* data, size_t size, size_t offset){
+        while(size > 0){
+            ssize_t written = pwrite(fd_, data, size, static_cast<off_t>(offset));
+            if(written < 0){
+                if(errno == EINTR) continue;
+                return errno;
+            }
+            // No progress, e.g. a full disk
+            if(written == 0) return ENOSPC;
+            data += written;
+            size -= static_cast<size_t>(written);
+            offset += static_cast<size_t>(written);
+        }
+        return 0;
+    }
+
+    spdlog::filename_t                  filename_;
+    int                                 fd_;
+    size_t                              offset_;        // file offset of the next buffer
+    size_t                              buffer_size_;
+    std::vector<buffer>                 buffers_;
+    size_t                              current_;       // buffer the records are appended to
+    unsigned                            in_flight_;
+    std::unique_ptr<details::uring>     ring_;
+    bool                                fixed_buffers_;
+    int                                 error_;
+};
+
+using io_uring_file_sink_mt = io_uring_file_sink<std::mutex>;
+using io_uring_file_sink_st = io_uring_file_sink<spdlog::details::null_mutex>;
+
+} // namespace sinks
+} // namespace spdlog_json_config
+
+#endif // __SPDLOG_JSON_CONFIG_IO_URING_FILE_SINK_H__
@@ -0,0 +1,168 @@
+#ifndef __SPDLOG_JSON_CONFIG_MMAP_FILE_SINK_H__
+#define __SPDLOG_JSON_CONFIG_MMAP_FILE_SINK_H__
+
+#include <string>
+#include <mutex>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "spdlog/sinks/base_sink.h"
+#include "spdlog/details/null_mutex.h"
+
+
+namespace spdlog_json_config {
+namespace sinks {
+
+/// @brief  msync policy of the mmap_file_sink on flush
+enum class msync_policy {
+    none,       ///< leave the dirty pages to the kernel, they survive a process crash
+    async,      ///< schedule the write back of the dirty pages (MS_ASYNC)
+    sync        ///< write back the dirty pages and wait for the disk (MS_SYNC)
+};
+
+/**
+ * @brief  Append only file sink writing through a shared memory mapping.
+ *
+ * The file is extended and mapped by windows of window_size bytes: a record is appended
+ * with a memcpy, without the stdio lock and buffer copy of the basic_file_sink. When the
+ * mapping is full, the file is extended with posix_fallocate and the mapping with mremap:
+ * the blocks are reserved, a full disk fails the record instead of raising SIGBUS.
+ * On close, the file is truncated to the data written. After a crash, the zeros of the
+ * preallocated window are trimmed when the file is reopened without truncate.
+ */
+template<typename Mutex>
+class mmap_file_sink : public spdlog::sinks::base_sink<Mutex> {
+public:
+    mmap_file_sink(const spdlog::filename_t& filename, bool truncate,
+                   size_t window_size, msync_policy policy)
+        : filename_(filename), fd_(-1), base_(nullptr), mapped_size_(0),
+          size_(0), synced_size_(0), policy_(policy){
+        size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        window_size_ = (window_size + page_size - 1) / page_size * page_size;
+        if(window_size_ == 0) window_size_ = page_size;
+
+        int flags = O_RDWR | O_CREAT | O_CLOEXEC;
+        if(truncate) flags |= O_TRUNC;
+        fd_ = ::open(filename_.c_str(), flags, 0644);
+        if(fd_ < 0){
+            spdlog::throw_spdlog_ex("mmap_file_sink: failed opening file " + filename_, errno);
+        }
+
+        struct stat st;
+        if(fstat(fd_, &st) != 0){
+            int err = errno;
+            ::close(fd_);
+            spdlog::throw_spdlog_ex("mmap_file_sink: failed getting size of " + filename_, err);
+        }
+        size_ = static_cast<size_t>(st.st_size);
+
+        try{
+            Map(size_ + window_size_);
+        }
+        catch(...){
+            ::close(fd_);
+            throw;
+        }
+
+        // Trim the zeros preallocated by a process which did not close the file
+        while(size_ > 0 && base_[size_ - 1] == '\0'){
+            size_--;
+        }
+        synced_size_ = size_;
+    }
+
+    ~mmap_file_sink() override {
+        if(base_ != nullptr){
+            if(policy_ != msync_policy::none){
+                msync(base_, mapped_size_, MS_SYNC);
+            }
+            munmap(base_, mapped_size_);
+        }
+        if(fd_ >= 0){
+            if(ftruncate(fd_, static_cast<off_t>(size_)) != 0){
+                // Nothing to do: the zeros are trimmed when the file is reopened
+            }
+            ::close(fd_);
+        }
+    }
+
+    mmap_file_sink(const mmap_file_sink&) = delete;
+    mmap_file_sink& operator=(const mmap_file_sink&) = delete;
+
+    const spdlog::filename_t& filename() const {
+        return filename_;
+    }
+
+protected:
+    void sink_it_(const spdlog::details::log_msg& msg) override {
+        spdlog::memory_buf_t formatted;
+        spdlog::sinks::base_sink<Mutex>::formatter_->format(msg, formatted);
+
+        if(size_ + formatted.size() > mapped_size_){
+            size_t new_size = mapped_size_ + window_size_;
+            while(size_ + formatted.size() > new_size){
+                new_size += window_size_;
+            }
+            Map(new_size);
+        }
+        memcpy(base_ + size_, formatted.data(), formatted.size());
+        size_ += formatted.size();
+    }
+
+    void flush_() override {
+        if(policy_ == msync_policy::none || synced_size_ == size_){
+            return;
+        }
+
+        // msync the pages written since the last flush
+        size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        size_t begin = synced_size_ / page_size * page_size;
+        if(msync(base_ + begin, size_ - begin, policy_ == msync_policy::sync ? MS_SYNC : MS_ASYNC) != 0){
+            spdlog::throw_spdlog_ex("mmap_file_sink: failed syncing file " + filename_, errno);
+        }
+        synced_size_ = size_;
+    }
+
+private:
+    /// @brief  Extend the file and the mapping to map_size bytes
+    void Map(size_t map_size){
+        int err = posix_fallocate(fd_, static_cast<off_t>(mapped_size_), static_cast<off_t>(map_size - mapped_size_));
+        if(err != 0){
+            spdlog::throw_spdlog_ex("mmap_file_sink: failed extending file " + filename_, err);
+        }
+
+        void* base;
+        if(base_ == nullptr){
+            base = mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        }
+        else {
+            base = mremap(base_, mapped_size_, map_size, MREMAP_MAYMOVE);
+        }
+        if(base == MAP_FAILED){
+            spdlog::throw_spdlog_ex("mmap_file_sink: failed mapping file " + filename_, errno);
+        }
+        base_ = static_cast<char*>(base);
+        mapped_size_ = map_size;
+    }
+
+    spdlog::filename_t  filename_;
+    int                 fd_;
+    char*               base_;
+    size_t              window_size_;
+    size_t              mapped_size_;
+    size_t              size_;          // bytes of log data in the file
+    size_t              synced_size_;   // bytes of log data msync'ed
+    msync_policy        policy_;
+};
+
+using mmap_file_sink_mt = mmap_file_sink<std::mutex>;
+using mmap_file_sink_st = mmap_file_sink<spdlog::details::null_mutex>;
+
+} // namespace sinks
+} // namespace spdlog_json_config
+
+#endif // __SPDLOG_JSON_CONFIG_MMAP_FILE_SINK_H__
@@ -0,0 +1,59 @@
+#ifndef __SPDLOG_JSON_CONFIG_PROXY_SINK_H__
+#define __SPDLOG_JSON_CONFIG_PROXY_SINK_H__
+
+#include <memory>
+#include <string>
+
+#include "spdlog/sinks/sink.h"
+#include "spdlog/formatter.h"
+
+
+namespace spdlog_json_config {
+namespace sinks {
+
+/**
+ * @brief  Base class of sinks which wrap another sink.
+ *
+ * The wrapped sink does the real output. The level configured for the sink is moved to
+ * the proxy, since it is the proxy the logger checks via should_log(). The wrapped sink
+ * is left at level trace. Pattern and formatter are forwarded to the wrapped sink.
+ */
+class proxy_sink : public spdlog::sinks::sink {
+public:
+    explicit proxy_sink(std::shared_ptr<spdlog::sinks::sink> sink)
+        : sink_(std::move(sink)) {
+        set_level(sink_->level());
+        sink_->set_level(spdlog::level::trace);
+    }
+
+    virtual ~proxy_sink() {}
+
+    void log(const spdlog::details::log_msg& msg) override {
+        sink_->log(msg);
+    }
+
+    void flush() override {
+        sink_->flush();
+    }
+
+    void set_pattern(const std::string& pattern) override {
+        sink_->set_pattern(pattern);
+    }
+
+    void set_formatter(std::unique_ptr<spdlog::formatter> sink_formatter) override {
+        sink_->set_formatter(std::move(sink_formatter));
+    }
+
+    /// @brief  Get the wrapped sink
+    const std::shared_ptr<spdlog::sinks::sink>& wrapped_sink() const {
+        return sink_;
+    }
+
+protected:
+    std::shared_ptr<spdlog::sinks::sink> sink_;
+};
+
+} // namespace sinks
+} // namespace spdlog_json_config
+
+#endif // __SPDLOG_JSON_CONFIG_PROXY_SINK_H__
@@ -0,0 +1,60 @@
+#ifndef __SPDLOG_JSON_CONFIG_RATE_LIMIT_SINK_H__
+#define __SPDLOG_JSON_CONFIG_RATE_LIMIT_SINK_H__
+
+#include <memory>
+#include <string>
+
+#include "proxy_sink.h"
+#include "../details/rate_limiter.h"
+
+
+namespace spdlog_json_config {
+namespace sinks {
+
+/**
+ * @brief  Sink dropping the records beyond a rate limit, see details::rate_limiter.
+ *
+ * The check is lock free. While records are suppressed, a summary of their count is
+ * written at level warn with the next record accepted, or on flush (e.g. by the periodic
+ * flusher), at most once per summary interval. Wrapping a sink limits that sink, wrapping
+ * the fanout_sink of a logger limits the logger.
+ */
+class rate_limit_sink : public proxy_sink {
+public:
+    rate_limit_sink(std::shared_ptr<spdlog::sinks::sink> sink, std::shared_ptr<details::rate_limiter> limiter,
+                    const std::string& name)
+        : proxy_sink(std::move(sink)), limiter_(std::move(limiter)), name_(name) {}
+
+    void log(const spdlog::details::log_msg& msg) override {
+        int64_t now = details::rate_limiter::now();
+        if(!limiter_->allow(now, msg.payload.size())){
+            return;
+        }
+        WriteSummary(now, msg.logger_name);
+        sink_->log(msg);
+    }
+
+    void flush() override {
+        WriteSummary(details::rate_limiter::now(), name_);
+        sink_->flush();
+    }
+
+private:
+    void WriteSummary(int64_t now, spdlog::string_view_t logger_name) {
+        uint64_t suppressed;
+        uint64_t suppressed_bytes;
+        if(limiter_->take_summary(now, suppressed, suppressed_bytes)){
+            std::string text = details::rate_limiter::summary(suppressed, suppressed_bytes);
+            spdlog::details::log_msg summary(logger_name, spdlog::level::warn, text);
+            sink_->log(summary);
+        }
+    }
+
+    std::shared_ptr<details::rate_limiter>  limiter_;
+    std::string                             name_;
+};
+
+} // namespace sinks
+} // namespace spdlog_json_config
+
+#endif // __SPDLOG_JSON_CONFIG_RATE_LIMIT_SINK_H__
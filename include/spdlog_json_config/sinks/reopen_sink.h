@@ -0,0 +1,82 @@
+#ifndef __SPDLOG_JSON_CONFIG_REOPEN_SINK_H__
+#define __SPDLOG_JSON_CONFIG_REOPEN_SINK_H__
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "spdlog/pattern_formatter.h"
+
+#include "proxy_sink.h"
+
+
+namespace spdlog_json_config {
+namespace sinks {
+
+/**
+ * @brief  Sink whose file sink can be created again, to follow a file moved by logrotate.
+ *
+ * On reopen(), a new sink is created by the reopen function, given the formatter of the
+ * previous one, and replaces it. The previous sink is flushed, and closed once the records
+ * being written to it are done. The wrapped sink is locked only to get it, not while the
+ * record is written, so wrapped_sink() is valid until the next reopen only.
+ */
+class reopen_sink : public proxy_sink {
+public:
+    reopen_sink(std::shared_ptr<spdlog::sinks::sink> sink, std::function<std::shared_ptr<spdlog::sinks::sink>()> reopen)
+        : proxy_sink(std::move(sink)), reopen_(std::move(reopen)) {}
+
+    void log(const spdlog::details::log_msg& msg) override {
+        Current()->log(msg);
+    }
+
+    void flush() override {
+        Current()->flush();
+    }
+
+    void set_pattern(const std::string& pattern) override {
+        set_formatter(std::unique_ptr<spdlog::formatter>(new spdlog::pattern_formatter(pattern)));
+    }
+
+    void set_formatter(std::unique_ptr<spdlog::formatter> sink_formatter) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        formatter_ = sink_formatter->clone();
+        sink_->set_formatter(std::move(sink_formatter));
+    }
+
+    /// @brief  Create the sink again and replace the current one
+    ///
+    /// @return false if the reopen function failed, the current sink is kept
+    bool reopen() {
+        std::shared_ptr<spdlog::sinks::sink> sink = reopen_();
+        if(sink == nullptr){
+            return false;
+        }
+        sink->set_level(spdlog::level::trace);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if(formatter_ != nullptr){
+                sink->set_formatter(formatter_->clone());
+            }
+            sink_.swap(sink);
+        }
+        sink->flush();
+        return true;
+    }
+
+private:
+    std::shared_ptr<spdlog::sinks::sink> Current() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return sink_;
+    }
+
+    std::function<std::shared_ptr<spdlog::sinks::sink>()>  reopen_;
+    std::mutex                                              mutex_;
+    std::unique_ptr<spdlog::formatter>                      formatter_;
+};
+
+} // namespace sinks
+} // namespace spdlog_json_config
+
+#endif // __SPDLOG_JSON_CONFIG_REOPEN_SINK_H__
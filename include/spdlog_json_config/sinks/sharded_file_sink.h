@@ -0,0 +1,183 @@
+#ifndef __SPDLOG_JSON_CONFIG_SHARDED_FILE_SINK_H__
+#define __SPDLOG_JSON_CONFIG_SHARDED_FILE_SINK_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <errno.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include "spdlog/sinks/sink.h"
+#include "spdlog/pattern_formatter.h"
+#include "spdlog/details/os.h"
+#include "spdlog/details/file_helper.h"
+
+
+namespace spdlog_json_config {
+namespace sinks {
+
+/**
+ * @brief  File sink writing the records of each thread to its own file.
+ *
+ * A thread gets its shard on its first record: the file base_file_name, with "{tid}"
+ * replaced by the thread id (or "-<tid>" added before the extension), its stdio buffer of
+ * buffer_size bytes and its formatter. A thread reusing the id of an exited thread continues
+ * the shard of that thread. The writing threads share nothing, the sink has no
+ * mutex on the logging path: the only lock taken is the one of the stdio file of the
+ * thread, never contended but by a flush from another thread. tools/shard_merge
+ * interleaves the shards by timestamp.
+ */
+class sharded_file_sink : public spdlog::sinks::sink {
+public:
+    sharded_file_sink(const spdlog::filename_t& base_file_name, bool truncate, size_t buffer_size)
+        : base_file_name_(base_file_name), truncate_(truncate), buffer_size_(buffer_size),
+          id_(NextSinkId()), formatter_(new spdlog::pattern_formatter()), formatter_version_(0) {}
+
+    ~sharded_file_sink() override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for(auto& shard : shards_){
+            fclose(shard->file);
+        }
+    }
+
+    sharded_file_sink(const sharded_file_sink&) = delete;
+    sharded_file_sink& operator=(const sharded_file_sink&) = delete;
+
+    void log(const spdlog::details::log_msg& msg) override {
+        shard* current = GetShard();
+        uint64_t version = formatter_version_.load(std::memory_order_acquire);
+        if(current->formatter_version != version){
+            std::lock_guard<std::mutex> lock(mutex_);
+            current->formatter = formatter_->clone();
+            current->formatter_version = formatter_version_.load(std::memory_order_relaxed);
+        }
+
+        current->formatted.clear();
+        current->formatter->format(msg, current->formatted);
+        if(fwrite(current->formatted.data(), 1, current->formatted.size(), current->file) != current->formatted.size()){
+            spdlog::throw_spdlog_ex("sharded_file_sink: failed writing to " + current->filename, errno);
+        }
+    }
+
+    /// @brief  Flush the files of all the threads, through their stdio lock
+    void flush() override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for(auto& shard : shards_){
+            fflush(shard->file);
+        }
+    }
+
+    void set_pattern(const std::string& pattern) override {
+        set_formatter(std::unique_ptr<spdlog::formatter>(new spdlog::pattern_formatter(pattern)));
+    }
+
+    void set_formatter(std::unique_ptr<spdlog::formatter> sink_formatter) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        formatter_ = std::move(sink_formatter);
+        formatter_version_.fetch_add(1, std::memory_order_release);
+    }
+
+    /// @brief  File names of the shards created so far
+    std::vector<spdlog::filename_t> filenames() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<spdlog::filename_t> names;
+        for(auto& shard : shards_){
+            names.push_back(shard->filename);
+        }
+        return names;
+    }
+
+    /// @brief  File name of the shard of the thread thread_id
+    spdlog::filename_t calc_filename(size_t thread_id) const {
+        std::string tid = std::to_string(thread_id);
+        spdlog::filename_t filename = base_file_name_;
+        size_t pos = filename.find("{tid}");
+        if(pos != spdlog::filename_t::npos){
+            return filename.replace(pos, 5, tid);
+        }
+        spdlog::filename_t basename, ext;
+        std::tie(basename, ext) = spdlog::details::file_helper::split_by_extension(filename);
+        return basename + "-" + tid + ext;
+    }
+
+private:
+    struct shard {
+        spdlog::filename_t                  filename;
+        FILE*                               file;
+        std::unique_ptr<char[]>             buffer;
+        std::unique_ptr<spdlog::formatter>  formatter;
+        uint64_t                            formatter_version;
+        spdlog::memory_buf_t                formatted;
+    };
+
+    /// Shard of the calling thread, created on its first record
+    shard* GetShard() {
+        // The sink ids are never reused, the entries of destroyed sinks are never matched
+        static thread_local uint64_t last_id = 0;
+        static thread_local shard* last_shard = nullptr;
+        static thread_local std::unordered_map<uint64_t, shard*> thread_shards;
+        if(last_id == id_){
+            return last_shard;
+        }
+
+        shard*& found = thread_shards[id_];
+        if(found == nullptr){
+            found = CreateShard();
+        }
+        last_id = id_;
+        last_shard = found;
+        return found;
+    }
+
+    shard* CreateShard() {
+        spdlog::filename_t filename = calc_filename(spdlog::details::os::thread_id());
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        // A thread id reused by the system gets the shard of the exited thread, and its file
+        for(auto& existing : shards_){
+            if(existing->filename == filename){
+                return existing.get();
+            }
+        }
+
+        std::unique_ptr<shard> created(new shard());
+        created->filename = filename;
+        created->file = fopen(created->filename.c_str(), truncate_ ? "wb" : "ab");
+        if(created->file == nullptr){
+            spdlog::throw_spdlog_ex("sharded_file_sink: failed opening file " + created->filename, errno);
+        }
+        if(buffer_size_ > 0){
+            created->buffer.reset(new char[buffer_size_]);
+            setvbuf(created->file, created->buffer.get(), _IOFBF, buffer_size_);
+        }
+        created->formatter = formatter_->clone();
+        created->formatter_version = formatter_version_.load(std::memory_order_relaxed);
+        shards_.push_back(std::move(created));
+        return shards_.back().get();
+    }
+
+    static uint64_t NextSinkId() {
+        static std::atomic<uint64_t> next_id(1);
+        return next_id.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    spdlog::filename_t                      base_file_name_;
+    bool                                    truncate_;
+    size_t                                  buffer_size_;
+    uint64_t                                id_;
+
+    std::mutex                              mutex_;         // shards_ and formatter_, not taken by log()
+    std::vector<std::unique_ptr<shard>>     shards_;
+    std::unique_ptr<spdlog::formatter>      formatter_;
+    std::atomic<uint64_t>                   formatter_version_;
+};
+
+} // namespace sinks
+} // namespace spdlog_json_config
+
+#endif // __SPDLOG_JSON_CONFIG_SHARDED_FILE_SINK_H__
@@ -0,0 +1,263 @@
+#ifndef __SPDLOG_JSON_CONFIG_UNIX_SOCKET_SINK_H__
+#define __SPDLOG_JSON_CONFIG_UNIX_SOCKET_SINK_H__
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+
+#include "spdlog/sinks/base_sink.h"
+#include "spdlog/details/null_mutex.h"
+
+
+namespace spdlog_json_config {
+namespace sinks {
+
+/// @brief  Socket type of the unix_socket_sink
+enum class unix_socket_type {
+    stream,     ///< SOCK_STREAM, the records are sent with sendmsg of up to IOV_MAX records
+    dgram       ///< SOCK_DGRAM, one datagram per record, sent with sendmmsg
+};
+
+/**
+ * @brief  Sink sending the formatted records to a local collector through a unix socket.
+ *
+ * The records are queued and sent by batches of batch_size records, and on flush. The
+ * socket is non blocking: while the collector is disconnected or does not keep up, the
+ * records stay queued, up to buffer_size bytes, beyond which the oldest ones are dropped
+ * and counted. A lost connection is retried on the next batch, with a delay doubled on
+ * each failure from reconnect_min up to reconnect_max.
+ */
+template<typename Mutex>
+class unix_socket_sink : public spdlog::sinks::base_sink<Mutex> {
+public:
+    unix_socket_sink(const std::string& socket_path, unix_socket_type type, size_t batch_size, size_t buffer_size,
+                     std::chrono::milliseconds reconnect_min, std::chrono::milliseconds reconnect_max)
+        : socket_path_(socket_path), type_(type), batch_size_(batch_size), buffer_size_(buffer_size),
+          reconnect_min_(reconnect_min), reconnect_max_(reconnect_max), reconnect_delay_(reconnect_min),
+          fd_(-1), pending_bytes_(0), sent_offset_(0), drops_(0) {
+        if(batch_size_ == 0) batch_size_ = 1;
+        if(socket_path_.size() >= sizeof(sockaddr_un::sun_path)){
+            spdlog::throw_spdlog_ex("unix_socket_sink: socket path too long " + socket_path_);
+        }
+        Connect();
+    }
+
+    ~unix_socket_sink() override {
+        try{
+            Send();
+        }
+        catch(...){
+        }
+        if(fd_ >= 0){
+            ::close(fd_);
+        }
+    }
+
+    unix_socket_sink(const unix_socket_sink&) = delete;
+    unix_socket_sink& operator=(const unix_socket_sink&) = delete;
+
+    /// @brief  Number of records dropped since the creation
+    size_t drops() const {
+        return drops_.load(std::memory_order_relaxed);
+    }
+
+    /// @brief  Whether the socket is connected to the collector
+    bool connected() {
+        std::lock_guard<Mutex> lock(spdlog::sinks::base_sink<Mutex>::mutex_);
+        return fd_ >= 0;
+    }
+
+protected:
+    void sink_it_(const spdlog::details::log_msg& msg) override {
+        spdlog::memory_buf_t formatted;
+        spdlog::sinks::base_sink<Mutex>::formatter_->format(msg, formatted);
+        pending_.push_back(std::string(formatted.data(), formatted.size()));
+        pending_bytes_ += formatted.size();
+        if(pending_.size() >= batch_size_){
+            Send();
+        }
+        DropOverflow();
+    }
+
+    void flush_() override {
+        Send();
+        DropOverflow();
+    }
+
+private:
+    bool Connect() {
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if(now < next_connect_){
+            return false;
+        }
+
+        int type = (type_ == unix_socket_type::stream) ? SOCK_STREAM : SOCK_DGRAM;
+        fd_ = ::socket(AF_UNIX, type | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if(fd_ >= 0){
+            struct sockaddr_un addr;
+            memset(&addr, 0, sizeof(addr));
+            addr.sun_family = AF_UNIX;
+            strncpy(addr.sun_path, socket_path_.c_str(), sizeof(addr.sun_path) - 1);
+            if(::connect(fd_, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) == 0){
+                reconnect_delay_ = reconnect_min_;
+                return true;
+            }
+            ::close(fd_);
+            fd_ = -1;
+        }
+
+        next_connect_ = now + reconnect_delay_;
+        reconnect_delay_ = std::min(reconnect_delay_ * 2, reconnect_max_);
+        return false;
+    }
+
+    void Disconnect() {
+        ::close(fd_);
+        fd_ = -1;
+        next_connect_ = std::chrono::steady_clock::now() + reconnect_delay_;
+        // A record partly sent on the stream is dropped, the collector lost its beginning
+        if(sent_offset_ > 0){
+            PopFront();
+            drops_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    /// Send the queued records until they are all sent or the socket would block
+    void Send() {
+        while(!pending_.empty()){
+            if(fd_ < 0 && !Connect()){
+                return;
+            }
+            bool sent = (type_ == unix_socket_type::stream) ? SendStream() : SendDgram();
+            if(!sent){
+                return;
+            }
+        }
+    }
+
+    /// @return false if no record could be sent
+    bool SendStream() {
+        size_t count = std::min(pending_.size(), static_cast<size_t>(IOV_MAX));
+        iovecs_.resize(count);
+        for(size_t i = 0; i < count; i++){
+            const std::string& record = pending_[i];
+            size_t offset = (i == 0) ? sent_offset_ : 0;
+            iovecs_[i].iov_base = const_cast<char*>(record.data() + offset);
+            iovecs_[i].iov_len  = record.size() - offset;
+        }
+        struct msghdr header;
+        memset(&header, 0, sizeof(header));
+        header.msg_iov    = iovecs_.data();
+        header.msg_iovlen = count;
+
+        ssize_t written = ::sendmsg(fd_, &header, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if(written < 0){
+            if(errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR){
+                Disconnect();
+            }
+            return false;
+        }
+
+        size_t remaining = static_cast<size_t>(written);
+        while(remaining > 0){
+            size_t left = pending_.front().size() - sent_offset_;
+            if(remaining < left){
+                sent_offset_ += remaining;
+                break;
+            }
+            remaining -= left;
+            PopFront();
+        }
+        return written > 0;
+    }
+
+    /// @return false if no record could be sent
+    bool SendDgram() {
+        size_t count = std::min(pending_.size(), static_cast<size_t>(IOV_MAX));
+        iovecs_.resize(count);
+        messages_.resize(count);
+        memset(messages_.data(), 0, count * sizeof(struct mmsghdr));
+        for(size_t i = 0; i < count; i++){
+            iovecs_[i].iov_base = const_cast<char*>(pending_[i].data());
+            iovecs_[i].iov_len  = pending_[i].size();
+            messages_[i].msg_hdr.msg_iov    = &iovecs_[i];
+            messages_[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        int sent = ::sendmmsg(fd_, messages_.data(), static_cast<unsigned>(count), MSG_NOSIGNAL | MSG_DONTWAIT);
+        if(sent < 0){
+            if(errno == EMSGSIZE){
+                // The record does not fit in a datagram
+                PopFront();
+                drops_.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+            if(errno != EAGAIN && errno != EWOULDBLOCK && errno != ENOBUFS && errno != EINTR){
+                Disconnect();
+            }
+            return false;
+        }
+        for(int i = 0; i < sent; i++){
+            PopFront();
+        }
+        return sent > 0;
+    }
+
+    void PopFront() {
+        pending_bytes_ -= pending_.front().size();
+        pending_.pop_front();
+        sent_offset_ = 0;
+    }
+
+    /// Drop the oldest records beyond buffer_size bytes, but not one partly sent
+    void DropOverflow() {
+        while(pending_bytes_ > buffer_size_ && !pending_.empty() && !(sent_offset_ > 0 && pending_.size() == 1)){
+            if(sent_offset_ > 0){
+                std::string& record = pending_[1];
+                pending_bytes_ -= record.size();
+                pending_.erase(pending_.begin() + 1);
+            }
+            else {
+                PopFront();
+            }
+            drops_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    std::string                             socket_path_;
+    unix_socket_type                        type_;
+    size_t                                  batch_size_;
+    size_t                                  buffer_size_;
+    std::chrono::milliseconds               reconnect_min_;
+    std::chrono::milliseconds               reconnect_max_;
+    std::chrono::milliseconds               reconnect_delay_;
+    std::chrono::steady_clock::time_point   next_connect_;
+    int                                     fd_;
+
+    std::deque<std::string>                 pending_;
+    size_t                                  pending_bytes_;
+    size_t                                  sent_offset_;   // bytes of the first record already sent
+    std::vector<struct iovec>               iovecs_;
+    std::vector<struct mmsghdr>             messages_;
+    std::atomic<size_t>                     drops_;
+};
+
+using unix_socket_sink_mt = unix_socket_sink<std::mutex>;
+using unix_socket_sink_st = unix_socket_sink<spdlog::details::null_mutex>;
+
+} // namespace sinks
+} // namespace spdlog_json_config
+
+#endif // __SPDLOG_JSON_CONFIG_UNIX_SOCKET_SINK_H__
@@ -5,15 +5,25 @@
 #include <string>
 #include <memory>
 #include <unordered_map>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <functional>
 #include <set>
+#include <atomic>
+#include <mutex>
+#include <map>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <limits.h>
 #include <stdint.h>
 #include <unistd.h>
 #include <libgen.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <assert.h>
+#include <dlfcn.h>
 
 #include "rapidjson/document.h"
 #include "rapidjson/error/en.h"
@@ -29,6 +39,32 @@
 #include "spdlog/sinks/daily_file_sink.h"
 #include "spdlog/sinks/rotating_file_sink.h"
 
+#include "sinks/dirty_tracking_sink.h"
+#include "sinks/mmap_file_sink.h"
+#include "sinks/io_uring_file_sink.h"
+#include "sinks/direct_file_sink.h"
+#include "sinks/compressed_file_sink.h"
+#include "sinks/binary_file_sink.h"
+#include "sinks/flight_recorder_sink.h"
+#include "sinks/fanout_sink.h"
+#include "sinks/format_group_sink.h"
+#include "sinks/backtrace_sink.h"
+#include "sinks/rate_limit_sink.h"
+#include "sinks/dedup_sink.h"
+#include "sinks/unix_socket_sink.h"
+#include "sinks/sharded_file_sink.h"
+#include "sinks/fadvise_sink.h"
+#include "sinks/buffered_sink.h"
+#include "sinks/reopen_sink.h"
+#include "details/periodic_flusher.h"
+#include "details/admin_server.h"
+#include "details/level_control.h"
+#include "details/background_compressor.h"
+#include "details/file_archive.h"
+#include "details/worker_pool.h"
+#include "deferred_async_logger.h"
+#include "plugin.h"
+
 
 namespace spdlog_json_config {
 
@@ -55,8 +91,13 @@ const static uint32_t DEFAULT_LOGGER_ID = 0;
  *          SpdlogJsonConfig::GetInstance()->GetLoggerId("foo", foo_logger_id);
  *          SpdlogJsonConfig::GetInstance()->GetLogger(foo_logger_id)->debug("log something");
  *
+ *   3. For a logger whose sync_type is "async_deferred", get it via GetDeferredLogger() to
+ *      format the messages in the worker thread instead of the calling thread.
+ *
+ *          SpdlogJsonConfig::GetInstance()->GetDeferredLogger(foo_logger_id)->debug("value {}", 42);
+ *
  */
-class SpdlogJsonConfig {
+class SpdlogJsonConfig : public plugin_registry {
 public:
     const constexpr static char* __CLASS__ = "SpdlogJsonConfig";
     const static uint32_t MAX_LOGGER_NUM = 32;  ///< Max number logger supported in logger manager
@@ -65,6 +106,11 @@ public:
     const constexpr static char* CONFIG_KEYWORD_PATTERNS   = "PATTERNS";
     const constexpr static char* CONFIG_KEYWORD_LOGGERS    = "LOGGERS";
     const constexpr static char* CONFIG_KEYWORD_THREADPOOL = "THREAD_POOL";
+    const constexpr static char* CONFIG_KEYWORD_FLUSH_INTERVAL = "flush_interval_ms";
+    const constexpr static char* CONFIG_KEYWORD_COMPRESS_CONCURRENCY = "compress_concurrency";
+    const constexpr static char* CONFIG_KEYWORD_PLUGINS    = "PLUGINS";
+    const constexpr static char* CONFIG_KEYWORD_ADMIN_SOCKET = "admin_socket";
+    const constexpr static char* CONFIG_KEYWORD_LEVEL_CONTROL = "level_control";
 
     const constexpr static char* SINK_TYPE_STDOUT_SINK_ST           = "stdout_sink_st";
     const constexpr static char* SINK_TYPE_STDOUT_SINK_MT           = "stdout_sink_mt";
@@ -82,7 +128,24 @@ public:
     const constexpr static char* SINK_TYPE_DAILY_FILE_SINK_MT       = "daily_file_sink_mt";
     const constexpr static char* SINK_TYPE_ROTATING_FILE_SINK_ST    = "rotating_file_sink_st";
     const constexpr static char* SINK_TYPE_ROTATING_FILE_SINK_MT    = "rotating_file_sink_mt";
-
+    const constexpr static char* SINK_TYPE_MMAP_FILE_SINK_ST        = "mmap_file_sink_st";
+    const constexpr static char* SINK_TYPE_MMAP_FILE_SINK_MT        = "mmap_file_sink_mt";
+    const constexpr static char* SINK_TYPE_IO_URING_FILE_SINK_ST    = "io_uring_file_sink_st";
+    const constexpr static char* SINK_TYPE_IO_URING_FILE_SINK_MT    = "io_uring_file_sink_mt";
+    const constexpr static char* SINK_TYPE_DIRECT_FILE_SINK_ST      = "direct_file_sink_st";
+    const constexpr static char* SINK_TYPE_DIRECT_FILE_SINK_MT      = "direct_file_sink_mt";
+    const constexpr static char* SINK_TYPE_COMPRESSED_FILE_SINK_ST  = "compressed_file_sink_st";
+    const constexpr static char* SINK_TYPE_COMPRESSED_FILE_SINK_MT  = "compressed_file_sink_mt";
+    const constexpr static char* SINK_TYPE_BINARY_FILE_SINK_ST      = "binary_file_sink_st";
+    const constexpr static char* SINK_TYPE_BINARY_FILE_SINK_MT      = "binary_file_sink_mt";
+    const constexpr static char* SINK_TYPE_FLIGHT_RECORDER_SINK_ST  = "flight_recorder_sink_st";
+    const constexpr static char* SINK_TYPE_FLIGHT_RECORDER_SINK_MT  = "flight_recorder_sink_mt";
+    const constexpr static char* SINK_TYPE_UNIX_SOCKET_SINK_ST      = "unix_socket_sink_st";
+    const constexpr static char* SINK_TYPE_UNIX_SOCKET_SINK_MT      = "unix_socket_sink_mt";
+    const constexpr static char* SINK_TYPE_SHARDED_FILE_SINK        = "sharded_file_sink";
+
+    /// @brief  Factory of a sink type, see sink_factory
+    typedef sink_factory SinkFactory;
 
     SpdlogJsonConfig(const spdlog::logger&) = delete;
     SpdlogJsonConfig& operator=(const spdlog::logger&) = delete;
@@ -121,12 +184,56 @@ public:
 
     /// @brief Get shared_ptr to spdlog::logger by logger id
     ///
+    /// With a level control file, the level of the logger is first updated to the level
+    /// written in the file by another process, if it changed.
+    ///
     /// @param logger_id    logger id
-    /// @return             shard_ptr to spdlog::logger
+    /// @return             shard_ptr to spdlog::logger, nullptr if the id is not given to a logger
     std::shared_ptr<spdlog::logger> GetLogger(uint32_t logger_id){
+        if(logger_id >= logger_count_){
+            return nullptr;
+        }
+        details::level_control::block* level_control = level_control_.load(std::memory_order_acquire);
+        if(level_control != nullptr &&
+           level_control->level(logger_id) != applied_levels_[logger_id].load(std::memory_order_relaxed)){
+            ApplyControlLevel(logger_id);
+        }
         return logger_table_[logger_id];
     }
 
+    /// @brief Get shared_ptr to the deferred_async_logger by logger id
+    ///
+    /// @param logger_id    logger id
+    /// @return             shared_ptr to deferred_async_logger, nullptr if the logger is not
+    ///                     queued on the worker pool ("async_deferred", or any async sync_type
+    ///                     with an elastic THREAD_POOL), or if the id is not given to a logger
+    std::shared_ptr<deferred_async_logger> GetDeferredLogger(uint32_t logger_id){
+        if(logger_id >= logger_count_){
+            return nullptr;
+        }
+        return deferred_table_[logger_id];
+    }
+
+    /// @brief Get shared_ptr to the deferred_async_logger by name
+    ///
+    /// @param logger_name  logger name
+    /// @return             shared_ptr to deferred_async_logger, nullptr if the logger is not
+    ///                     found or not queued on the worker pool
+    std::shared_ptr<deferred_async_logger> GetDeferredLogger(const std::string& logger_name){
+        std::unordered_map<std::string, uint32_t>::iterator it = name_to_id_.find(logger_name);
+        if(it == name_to_id_.end()){
+            return nullptr;
+        }
+        return deferred_table_[it->second];
+    }
+
+    /// @brief  Get the worker pool of the loggers queued on it
+    ///
+    /// @return shared_ptr to the worker pool, nullptr if no logger uses it
+    std::shared_ptr<details::worker_pool> GetWorkerPool(){
+        return worker_pool_;
+    }
+
     /// @brief  Get logger id by logger name
     ///
     /// @param  [in] logger_name     the logger name
@@ -144,31 +251,173 @@ public:
         return true;
     }
 
+    /// @brief  Register the factory of a sink type, to use the type in the SINKS section
+    ///
+    /// To be called before Initialize(). The types ending with "_mt" must be thread safe:
+    /// they are flushed by the periodic flusher thread.
+    ///
+    /// @param  sink_type  the type, as the value of "type" in the sink configuration
+    /// @param  factory    the factory creating the sinks of the type
+    /// @return false if the type is already registered
+    bool RegisterSinkType(const std::string& sink_type, SinkFactory factory){
+        if(sink_factories_.find(sink_type) != sink_factories_.end()){
+            printf("%s::%s: sink type '%s' already registered\n", __CLASS__, __FUNCTION__, sink_type.c_str());
+            return false;
+        }
+        sink_factories_[sink_type] = std::move(factory);
+        return true;
+    }
+
+    /// @brief  Register the factory of a sink type of a plugin, see RegisterSinkType()
+    bool register_sink_type(const std::string& sink_type, sink_factory factory) override {
+        return RegisterSinkType(sink_type, std::move(factory));
+    }
+
+    /// @brief  Stop logging, drain the async queues and close the sinks
+    ///
+    /// New messages are dropped: the level of every configured logger is set to off.
+    /// The async queues are drained until they are empty or the deadline expires, then
+    /// the sinks are flushed and released. The loggers are replaced by loggers without
+    /// sinks, so getting and using a logger by name after Shutdown() is harmless.
+    /// A sink is closed once the loggers still held by the application are released.
+    ///
+    /// The logger ids are reclaimed: GetLogger(id) returns nullptr until the next
+    /// Initialize(), which gives the ids again from the first one.
+    ///
+    /// If messages are left at the deadline, e.g. on a stalled disk, the worker pools are
+    /// given up instead of being joined, see Abandon(), and only the sinks written by no
+    /// async logger are flushed: the others may be in use by a stuck worker.
+    /// The rotated files are compressed until the deadline as well.
+    ///
+    /// @param  deadline  max time to wait for the async queues to drain
+    /// @return number of messages left in the async queues
+    size_t Shutdown(std::chrono::milliseconds deadline){
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now() + deadline;
+        admin_server_.reset();
+        CloseLevelControl();
+
+        // Stop accepting messages. No flush is queued: it could block on a full queue.
+        // The sinks are flushed once the workers are done with them.
+        for(uint32_t i = DEFAULT_LOGGER_ID + 1; i < logger_count_; i++){
+            logger_table_[i]->set_level(spdlog::level::off);
+        }
+
+        size_t pending = PendingMessages();
+        while(pending > 0 && std::chrono::steady_clock::now() < end){
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            pending = PendingMessages();
+        }
+
+        std::shared_ptr<spdlog::details::thread_pool> tp = spdlog::details::registry::instance().get_tp();
+        spdlog::details::registry::instance().set_tp(nullptr);
+        if(pending > 0){
+            printf("%s::%s: %lu messages left at the deadline\n", __CLASS__, __FUNCTION__, pending);
+
+            // The workers may be stuck on a sink, and the periodic flusher with them
+            Abandon(std::move(worker_pool_));
+            Abandon(std::move(tp));
+            Abandon(std::shared_ptr<details::periodic_flusher>(std::move(periodic_flusher_)));
+        }
+        else {
+            // Join the workers, so that the messages they are writing reach the sinks before the flush
+            worker_pool_.reset();
+            tp.reset();
+            periodic_flusher_.reset();
+        }
+
+        std::unordered_map<std::string, std::shared_ptr<spdlog::sinks::sink>>::iterator sink_it;
+        for(sink_it = sink_map_.begin(); sink_it != sink_map_.end(); sink_it++){
+            if(pending > 0 && async_sinks_.count(sink_it->first) > 0){
+                continue;
+            }
+            try{
+                sink_it->second->flush();
+            }
+            catch(const std::exception& ex){
+                printf("%s::%s: Flush sink '%s' failure: %s\n",
+                       __CLASS__, __FUNCTION__, sink_it->first.c_str(), ex.what());
+            }
+        }
+
+        // Replace the loggers by loggers without sinks and release the sinks
+        std::vector<std::shared_ptr<spdlog::sinks::sink>> no_sinks;
+        for(uint32_t i = DEFAULT_LOGGER_ID + 1; i < logger_count_; i++){
+            std::string logger_name = logger_table_[i]->name();
+            if(deferred_table_[i] != nullptr){
+                deferred_table_[i] = std::make_shared<deferred_async_logger>(logger_name,
+                                         no_sinks.begin(), no_sinks.end(), std::weak_ptr<details::worker_pool>(), 2);
+                logger_table_[i] = deferred_table_[i];
+            }
+            else {
+                logger_table_[i] = std::make_shared<spdlog::logger>(logger_name);
+            }
+            logger_table_[i]->set_level(spdlog::level::off);
+
+            spdlog::drop(logger_name);
+            spdlog::register_logger(logger_table_[i]);
+            released_loggers_.insert(logger_name);
+            name_to_id_.erase(logger_name);
+            logger_table_[i] = nullptr;
+            deferred_table_[i] = nullptr;
+        }
+        logger_count_ = DEFAULT_LOGGER_ID + 1;
+        sink_map_.clear();
+        async_sinks_.clear();
+
+        // The rotated files not compressed by the deadline are compressed by the next run
+        if(compressor_ != nullptr){
+            compressor_->stop(end);
+            compressor_.reset();
+        }
+
+        return pending;
+    }
+
 private:
 
     /// @brief  Default constructor. Create the default logger.
     SpdlogJsonConfig(){
         for(uint32_t i = 0; i < MAX_LOGGER_NUM; i++){
             logger_table_[i] = nullptr;
+            applied_levels_[i].store(0);
+            deferred_table_[i] = nullptr;
         }
         logger_count_ = 0;
-
-        supported_sink_type_.insert(SINK_TYPE_STDOUT_SINK_ST);
-        supported_sink_type_.insert(SINK_TYPE_STDOUT_SINK_MT);
-        supported_sink_type_.insert(SINK_TYPE_STDERR_SINK_ST);
-        supported_sink_type_.insert(SINK_TYPE_STDERR_SINK_MT);
-        supported_sink_type_.insert(SINK_TYPE_STDOUT_COLOR_SINK_ST);
-        supported_sink_type_.insert(SINK_TYPE_STDOUT_COLOR_SINK_MT);
-        supported_sink_type_.insert(SINK_TYPE_STDERR_COLOR_SINK_ST);
-        supported_sink_type_.insert(SINK_TYPE_STDERR_COLOR_SINK_MT);
-        supported_sink_type_.insert(SINK_TYPE_SYSLOG_SINK_ST);
-        supported_sink_type_.insert(SINK_TYPE_SYSLOG_SINK_MT);
-        supported_sink_type_.insert(SINK_TYPE_BASIC_FILE_SINK_ST);
-        supported_sink_type_.insert(SINK_TYPE_BASIC_FILE_SINK_MT);
-        supported_sink_type_.insert(SINK_TYPE_DAILY_FILE_SINK_ST);
-        supported_sink_type_.insert(SINK_TYPE_DAILY_FILE_SINK_MT);
-        supported_sink_type_.insert(SINK_TYPE_ROTATING_FILE_SINK_ST);
-        supported_sink_type_.insert(SINK_TYPE_ROTATING_FILE_SINK_MT);
+        flush_interval_ms_ = 0;
+        compress_concurrency_ = 1;
+        level_control_.store(nullptr);
+
+        RegisterSinkType(SINK_TYPE_STDOUT_SINK_ST, CreateConsoleSink<spdlog::sinks::stdout_sink_st>);
+        RegisterSinkType(SINK_TYPE_STDOUT_SINK_MT, CreateConsoleSink<spdlog::sinks::stdout_sink_mt>);
+        RegisterSinkType(SINK_TYPE_STDERR_SINK_ST, CreateConsoleSink<spdlog::sinks::stderr_sink_st>);
+        RegisterSinkType(SINK_TYPE_STDERR_SINK_MT, CreateConsoleSink<spdlog::sinks::stderr_sink_mt>);
+        RegisterSinkType(SINK_TYPE_STDOUT_COLOR_SINK_ST, CreateConsoleSink<spdlog::sinks::stdout_color_sink_st>);
+        RegisterSinkType(SINK_TYPE_STDOUT_COLOR_SINK_MT, CreateConsoleSink<spdlog::sinks::stdout_color_sink_mt>);
+        RegisterSinkType(SINK_TYPE_STDERR_COLOR_SINK_ST, CreateConsoleSink<spdlog::sinks::stderr_color_sink_st>);
+        RegisterSinkType(SINK_TYPE_STDERR_COLOR_SINK_MT, CreateConsoleSink<spdlog::sinks::stderr_color_sink_mt>);
+        RegisterSinkType(SINK_TYPE_SYSLOG_SINK_ST, BindSinkFactory(&SpdlogJsonConfig::CreateSyslogSink));
+        RegisterSinkType(SINK_TYPE_SYSLOG_SINK_MT, BindSinkFactory(&SpdlogJsonConfig::CreateSyslogSink));
+        RegisterSinkType(SINK_TYPE_BASIC_FILE_SINK_ST, BindSinkFactory(&SpdlogJsonConfig::CreateBasicFileSink));
+        RegisterSinkType(SINK_TYPE_BASIC_FILE_SINK_MT, BindSinkFactory(&SpdlogJsonConfig::CreateBasicFileSink));
+        RegisterSinkType(SINK_TYPE_DAILY_FILE_SINK_ST, BindSinkFactory(&SpdlogJsonConfig::CreateDailyFileSink));
+        RegisterSinkType(SINK_TYPE_DAILY_FILE_SINK_MT, BindSinkFactory(&SpdlogJsonConfig::CreateDailyFileSink));
+        RegisterSinkType(SINK_TYPE_ROTATING_FILE_SINK_ST, BindSinkFactory(&SpdlogJsonConfig::CreateRotatingFileSink));
+        RegisterSinkType(SINK_TYPE_ROTATING_FILE_SINK_MT, BindSinkFactory(&SpdlogJsonConfig::CreateRotatingFileSink));
+        RegisterSinkType(SINK_TYPE_MMAP_FILE_SINK_ST, BindSinkFactory(&SpdlogJsonConfig::CreateMmapFileSink));
+        RegisterSinkType(SINK_TYPE_MMAP_FILE_SINK_MT, BindSinkFactory(&SpdlogJsonConfig::CreateMmapFileSink));
+        RegisterSinkType(SINK_TYPE_IO_URING_FILE_SINK_ST, BindSinkFactory(&SpdlogJsonConfig::CreateIoUringFileSink));
+        RegisterSinkType(SINK_TYPE_IO_URING_FILE_SINK_MT, BindSinkFactory(&SpdlogJsonConfig::CreateIoUringFileSink));
+        RegisterSinkType(SINK_TYPE_DIRECT_FILE_SINK_ST, BindSinkFactory(&SpdlogJsonConfig::CreateDirectFileSink));
+        RegisterSinkType(SINK_TYPE_DIRECT_FILE_SINK_MT, BindSinkFactory(&SpdlogJsonConfig::CreateDirectFileSink));
+        RegisterSinkType(SINK_TYPE_COMPRESSED_FILE_SINK_ST, BindSinkFactory(&SpdlogJsonConfig::CreateCompressedFileSink));
+        RegisterSinkType(SINK_TYPE_COMPRESSED_FILE_SINK_MT, BindSinkFactory(&SpdlogJsonConfig::CreateCompressedFileSink));
+        RegisterSinkType(SINK_TYPE_BINARY_FILE_SINK_ST, BindSinkFactory(&SpdlogJsonConfig::CreateBinaryFileSink));
+        RegisterSinkType(SINK_TYPE_BINARY_FILE_SINK_MT, BindSinkFactory(&SpdlogJsonConfig::CreateBinaryFileSink));
+        RegisterSinkType(SINK_TYPE_FLIGHT_RECORDER_SINK_ST, BindSinkFactory(&SpdlogJsonConfig::CreateFlightRecorderSink));
+        RegisterSinkType(SINK_TYPE_FLIGHT_RECORDER_SINK_MT, BindSinkFactory(&SpdlogJsonConfig::CreateFlightRecorderSink));
+        RegisterSinkType(SINK_TYPE_UNIX_SOCKET_SINK_ST, BindSinkFactory(&SpdlogJsonConfig::CreateUnixSocketSink));
+        RegisterSinkType(SINK_TYPE_UNIX_SOCKET_SINK_MT, BindSinkFactory(&SpdlogJsonConfig::CreateUnixSocketSink));
+        RegisterSinkType(SINK_TYPE_SHARDED_FILE_SINK, BindSinkFactory(&SpdlogJsonConfig::CreateShardedFileSink));
 
         DEFAULT_PATTERN = std::string("[%C-%m-%d %H:%M:%S.%e][%n]%^[%L]%$ %v");
         DEFAULT_SINK    = std::make_shared<spdlog::sinks::stdout_color_sink_st>();
@@ -261,6 +510,11 @@ private:
         //
         uint32_t thread_count = 1;
         uint32_t queue_size = 8192;
+        uint32_t min_threads = 0;           // the worker pool is elastic if min_threads or max_threads is set
+        uint32_t max_threads = 0;
+        uint32_t grow_threshold = 1024;     // pending records per worker above which a worker is added
+        uint32_t shrink_idle_ms = 1000;     // idle time after which an extra worker retires
+        std::string affinity;               // "logger" or "sink" to partition the worker pool
         it = doc.FindMember(CONFIG_KEYWORD_THREADPOOL);
         if(it != doc.MemberEnd()){
             const rapidjson::Value& threadpool_config = it->value;
@@ -271,13 +525,128 @@ private:
             if ((it = threadpool_config.FindMember("queue_size")) != threadpool_config.MemberEnd()){
                 queue_size = it->value.GetUint();
             }
+
+            if ((it = threadpool_config.FindMember("min_threads")) != threadpool_config.MemberEnd()){
+                min_threads = it->value.GetUint();
+            }
+
+            if ((it = threadpool_config.FindMember("max_threads")) != threadpool_config.MemberEnd()){
+                max_threads = it->value.GetUint();
+            }
+
+            if ((it = threadpool_config.FindMember("grow_threshold")) != threadpool_config.MemberEnd()){
+                grow_threshold = it->value.GetUint();
+            }
+
+            if ((it = threadpool_config.FindMember("shrink_idle_ms")) != threadpool_config.MemberEnd()){
+                shrink_idle_ms = it->value.GetUint();
+            }
+
+            if ((it = threadpool_config.FindMember("affinity")) != threadpool_config.MemberEnd()){
+                affinity = std::string(it->value.GetString());
+            }
+        }
+
+        worker_pool_.reset();
+        bool elastic_pool = (min_threads > 0 || max_threads > 0);
+        if(!affinity.empty()){
+            // async loggers are pinned to one of "thread_count" workers according to their
+            // name ("logger") or the group of loggers sharing sinks with them ("sink")
+            if(affinity != "logger" && affinity != "sink"){
+                printf("%s::%s: Unknown thread pool affinity '%s'\n", __CLASS__, __FUNCTION__, affinity.c_str());
+                return false;
+            }
+            if(elastic_pool){
+                printf("%s::%s: min_threads and max_threads ignored with affinity. Use thread_count %u\n",
+                       __CLASS__, __FUNCTION__, thread_count);
+            }
+            worker_pool_ = std::make_shared<details::worker_pool>(thread_count, true);
+        }
+        else if(elastic_pool){
+            // "async", "async_nb" and "async_deferred" loggers are all queued on the elastic worker pool
+            if(min_threads == 0) min_threads = 1;
+            if(max_threads < min_threads) max_threads = min_threads;
+            worker_pool_ = std::make_shared<details::worker_pool>(min_threads, max_threads,
+                                                                  grow_threshold, shrink_idle_ms);
+        }
+        else {
+            // create thread pool
+            // The worker pool of the "async_deferred" loggers is created with the first of them.
+            // All async loggers are queued on the worker pool if it is elastic or partitioned.
+            std::shared_ptr<spdlog::details::thread_pool> tp =
+                    std::make_shared<spdlog::details::thread_pool>(queue_size, thread_count);
+            spdlog::details::registry::instance().set_tp(tp);
+        }
+
+        bool pooled_async = (worker_pool_ != nullptr);
+
+        //
+        // Get the path of the admin socket. The file sinks can be reopened only if it is configured.
+        // The admin thread is stopped while the loggers are configured.
+        //
+        admin_server_.reset();
+        admin_socket_path_.clear();
+        it = doc.FindMember(CONFIG_KEYWORD_ADMIN_SOCKET);
+        if(it != doc.MemberEnd()){
+            admin_socket_path_ = std::string(it->value.GetString());
+        }
+
+        //
+        // Get the path of the level control file, true for /dev/shm/<program>.<pid>.loglevels.
+        // The file is not read while the loggers are configured.
+        //
+        CloseLevelControl();
+        std::string level_control_path;
+        it = doc.FindMember(CONFIG_KEYWORD_LEVEL_CONTROL);
+        if(it != doc.MemberEnd()){
+            if(it->value.IsBool()){
+                if(it->value.GetBool()){
+                    level_control_path = std::string("/dev/shm/") + program_invocation_short_name + "." +
+                                         std::to_string(getpid()) + ".loglevels";
+                }
+            }
+            else {
+                level_control_path = std::string(it->value.GetString());
+            }
+        }
+
+        //
+        // Get periodic flush interval. Sinks are tracked only if it is configured.
+        //
+        periodic_flusher_.reset();
+        flush_interval_ms_ = 0;
+        it = doc.FindMember(CONFIG_KEYWORD_FLUSH_INTERVAL);
+        if(it != doc.MemberEnd()){
+            flush_interval_ms_ = it->value.GetUint();
         }
 
-        // create thread pool
-        std::shared_ptr<spdlog::details::thread_pool> tp =
-                std::make_shared<spdlog::details::thread_pool>(queue_size, thread_count);
-        spdlog::details::registry::instance().set_tp(tp);
+        //
+        // Get the number of threads compressing the rotated files. Started by the first sink compressing them.
+        //
+        compressor_.reset();
+        compress_concurrency_ = 1;
+        it = doc.FindMember(CONFIG_KEYWORD_COMPRESS_CONCURRENCY);
+        if(it != doc.MemberEnd()){
+            compress_concurrency_ = it->value.GetUint();
+        }
 
+        //
+        // Load the plugins registering sink types
+        //
+        it = doc.FindMember(CONFIG_KEYWORD_PLUGINS);
+        if(it != doc.MemberEnd()){
+            const rapidjson::Value& plugins = it->value;
+            if(!plugins.IsArray()){
+                printf("%s::%s: %s must be an array of paths\n", __CLASS__, __FUNCTION__, CONFIG_KEYWORD_PLUGINS);
+                return false;
+            }
+            rapidjson::Value::ConstValueIterator plugin_it;
+            for(plugin_it = plugins.Begin(); plugin_it != plugins.End(); plugin_it++){
+                if(!LoadPlugin(plugin_it->GetString())){
+                    return false;
+                }
+            }
+        }
 
         //
         // Get sinks configuration
@@ -293,6 +662,12 @@ private:
             }
         }
 
+        // the sinks writing the same file share the sink of one of them
+        std::unordered_map<std::string, std::string> sink_owner;
+        if(!FindSharedSinks(sink_config, sink_owner)){
+            return false;
+        }
+
         //
         // Get patterns configuration
         //
@@ -314,8 +689,29 @@ private:
                 // list to store sinks that will be used in a logger
                 std::vector<std::shared_ptr<spdlog::sinks::sink>> sink_list;
                 const rapidjson::Value& loggers_config = it->value;
+
+                // partition key of every logger for a partitioned worker pool
+                std::unordered_map<std::string, std::string> sink_groups;
+                if(affinity == "sink"){
+                    sink_groups = GroupLoggersBySinks(loggers_config, sink_owner);
+                }
+
+                // sinks formatted once per record by a format_group_sink in all their loggers
+                std::set<std::string> format_once_sinks = FindFormatOnceSinks(loggers_config, sink_config, pattern_config);
+
+                // the sinks sharing a file share its formatter: they are grouped together or not at all
+                std::set<std::string> grouped_owners;
+                std::unordered_map<std::string, std::string>::iterator owner_it;
+                for(owner_it = sink_owner.begin(); owner_it != sink_owner.end(); owner_it++){
+                    if(format_once_sinks.count(owner_it->first) > 0) grouped_owners.insert(owner_it->second);
+                }
+                for(owner_it = sink_owner.begin(); owner_it != sink_owner.end(); owner_it++){
+                    if(grouped_owners.count(owner_it->second) > 0) format_once_sinks.insert(owner_it->first);
+                }
+
                 for(it = loggers_config.MemberBegin(); it != loggers_config.MemberEnd(); it++){
                     sink_list.clear();
+                    std::vector<std::string> sink_names;
                     std::string logger_name(it->name.GetString());    // get logger name
                     const rapidjson::Value& logger_param = it->value; // configuration for the logger
 
@@ -347,7 +743,10 @@ private:
                                         return false;
                                     }
 
-                                    if(!GenerateSink(sink_name, sink_config_it->second, pattern_config)){
+                                    bool generated = sink_owner.count(sink_name) > 0 ?
+                                        GenerateSharedSinks(sink_owner[sink_name], sink_owner, sink_config, pattern_config) :
+                                        GenerateSink(sink_name, sink_config_it->second, pattern_config);
+                                    if(!generated){
                                         printf("%s::%s: Generate sink '%s' failure\n",
                                                __CLASS__, __FUNCTION__, sink_name.c_str());
                                         return false;
@@ -355,6 +754,7 @@ private:
                                 }
 
                                 sink_list.push_back(sink_map_[sink_name]);
+                                sink_names.push_back(sink_name);
                             }
                         }
                     }
@@ -362,6 +762,7 @@ private:
                         printf("%s::%s: No sinks defined for logger '%s'. Use default sink",
                                __CLASS__, __FUNCTION__, logger_name.c_str());
                         sink_list.push_back(DEFAULT_SINK);
+                        sink_names.push_back(std::string());
                     }
 
                     //
@@ -387,6 +788,44 @@ private:
                         logger_pattern = DEFAULT_PATTERN;
                     }
 
+                    //
+                    // set the formatters of the sinks: the pattern of a sink wins over the pattern of
+                    // the logger. The grouped sinks are replaced by one group per pattern, in place of
+                    // the first sink of the group, formatting for all of them.
+                    //
+                    std::vector<std::shared_ptr<spdlog::sinks::sink>> logger_sinks;
+                    std::map<std::string, std::vector<std::shared_ptr<spdlog::sinks::sink>>> groups;
+                    std::map<std::string, size_t> group_index;
+                    for(size_t i = 0; i < sink_list.size(); i++){
+                        std::string pattern = GetSinkPattern(sink_names[i], sink_config, pattern_config);
+                        bool own_pattern = !pattern.empty();
+                        if(!own_pattern){
+                            pattern = logger_pattern;
+                        }
+                        if(format_once_sinks.count(sink_names[i]) > 0){
+                            if(groups.find(pattern) == groups.end()){
+                                group_index[pattern] = logger_sinks.size();
+                                logger_sinks.push_back(nullptr);
+                            }
+                            groups[pattern].push_back(sink_list[i]);
+                        }
+                        else {
+                            // the pattern of the sink was set when generating it
+                            if(!own_pattern){
+                                sink_list[i]->set_formatter(
+                                    std::unique_ptr<spdlog::formatter>(new spdlog::pattern_formatter(pattern)));
+                            }
+                            logger_sinks.push_back(sink_list[i]);
+                        }
+                    }
+                    std::map<std::string, std::vector<std::shared_ptr<spdlog::sinks::sink>>>::iterator group_it;
+                    for(group_it = groups.begin(); group_it != groups.end(); group_it++){
+                        logger_sinks[group_index[group_it->first]] = std::make_shared<sinks::format_group_sink>(
+                            group_it->second,
+                            std::unique_ptr<spdlog::formatter>(new spdlog::pattern_formatter(group_it->first)));
+                    }
+                    sink_list.swap(logger_sinks);
+
                     //
                     // get level for logger
                     //
@@ -401,6 +840,50 @@ private:
                         logger_level = std::string("info");
                     }
 
+                    //
+                    // get backtrace for logger: the last records below the level are
+                    // kept, and written before a record at or above the dump_on level
+                    //
+                    uint32_t backtrace_size = 0;
+                    std::string dump_on("error");
+                    param_it = logger_param.FindMember("backtrace");
+                    if(param_it != logger_param.MemberEnd()){
+                        backtrace_size = param_it->value.GetUint();
+                    }
+                    param_it = logger_param.FindMember("dump_on");
+                    if(param_it != logger_param.MemberEnd()){
+                        dump_on = std::string(param_it->value.GetString());
+                    }
+                    if(backtrace_size > 0){
+                        std::shared_ptr<spdlog::sinks::sink> backtrace =
+                            std::make_shared<sinks::backtrace_sink>(std::make_shared<sinks::fanout_sink>(sink_list),
+                                                                    spdlog::level::from_str(logger_level),
+                                                                    backtrace_size, spdlog::level::from_str(dump_on));
+                        sink_list.assign(1, backtrace);
+                    }
+
+                    //
+                    // get rate limit for logger, applied to all its records
+                    //
+                    std::shared_ptr<details::rate_limiter> rate_limiter;
+                    if(!ParseRateLimit(logger_name, logger_param, rate_limiter)){
+                        return false;
+                    }
+                    if(rate_limiter != nullptr){
+                        std::shared_ptr<spdlog::sinks::sink> front = (sink_list.size() == 1) ? sink_list[0] :
+                            std::make_shared<sinks::fanout_sink>(sink_list);
+                        sink_list.assign(1, std::make_shared<sinks::rate_limit_sink>(front, rate_limiter, logger_name));
+                    }
+
+                    //
+                    // get flush level for logger
+                    //
+                    std::string flush_level;
+                    param_it = logger_param.FindMember("flush_on");
+                    if(param_it != logger_param.MemberEnd()){
+                        flush_level = std::string(param_it->value.GetString());
+                    }
+
                     //
                     // get sync type for logger
                     //
@@ -410,34 +893,92 @@ private:
                         sync_type = std::string(param_it->value.GetString());
                     }
 
+                    // A logger configured again keeps its id. The ids are reclaimed by Shutdown().
+                    uint32_t logger_id = logger_count_;
+                    std::unordered_map<std::string, uint32_t>::iterator id_it = name_to_id_.find(logger_name);
+                    if(id_it != name_to_id_.end()){
+                        if(id_it->second == DEFAULT_LOGGER_ID){
+                            printf("%s::%s: Logger name '%s' is reserved\n", __CLASS__, __FUNCTION__, logger_name.c_str());
+                            return false;
+                        }
+                        logger_id = id_it->second;
+                    }
+                    else if(logger_count_ >= MAX_LOGGER_NUM){
+                        printf("%s::%s: Too many loggers, logger '%s' exceeds %u\n",
+                               __CLASS__, __FUNCTION__, logger_name.c_str(), MAX_LOGGER_NUM);
+                        return false;
+                    }
+                    deferred_table_[logger_id] = nullptr;
+
                     // Create logger according to sync_type
                     std::shared_ptr<spdlog::logger> logger;
                     if (sync_type == "sync"){
                         logger = CreateSync(logger_name, sink_list);
                     }
-                    else if(sync_type == "async"){
+                    else if(sync_type == "async" && !pooled_async){
                         logger = CreateAsync(logger_name, sink_list);
                     }
-                    else if(sync_type == "async_nb"){
+                    else if(sync_type == "async_nb" && !pooled_async){
                         logger = CreateAsyncNB(logger_name, sink_list);
                     }
+                    else if(sync_type == "async" || sync_type == "async_deferred"){
+                        deferred_table_[logger_id] =
+                            CreateAsyncDeferred(logger_name, sink_list, thread_count, queue_size,
+                                                spdlog::async_overflow_policy::block);
+                        logger = deferred_table_[logger_id];
+                    }
+                    else if(sync_type == "async_nb"){
+                        deferred_table_[logger_id] =
+                            CreateAsyncDeferred(logger_name, sink_list, thread_count, queue_size,
+                                                spdlog::async_overflow_policy::overrun_oldest);
+                        logger = deferred_table_[logger_id];
+                    }
                     else {
                         fprintf(stderr, "Unknown sync_type: %s\n", sync_type.c_str());
                         return false;
                     }
 
+                    if(sync_type != "sync"){
+                        // with the sinks sharing their file
+                        for(const std::string& sink_name : sink_names){
+                            async_sinks_.insert(sink_name);
+                            if(sink_owner.count(sink_name) == 0){
+                                continue;
+                            }
+                            for(owner_it = sink_owner.begin(); owner_it != sink_owner.end(); owner_it++){
+                                if(owner_it->second == sink_owner[sink_name]){
+                                    async_sinks_.insert(owner_it->first);
+                                }
+                            }
+                        }
+                    }
+
                     //spdlog::set_async_mode(4096);
                     //auto logger = std::make_shared<spdlog::logger>(logger_name, begin(sink_list), end(sink_list));
 
-                    logger->set_level(spdlog::level::from_str(logger_level));
-                    logger->set_pattern(logger_pattern);
+                    if(deferred_table_[logger_id] != nullptr && worker_pool_->partitioned()){
+                        const std::string& key = (affinity == "sink") ? sink_groups[logger_name] : logger_name;
+                        deferred_table_[logger_id]->set_partition(worker_pool_->partition_of(key));
+                    }
+
+                    // with a backtrace, the records below the level go to the backtrace sink
+                    logger->set_level(backtrace_size > 0 ? spdlog::level::trace : spdlog::level::from_str(logger_level));
+                    if(!flush_level.empty()){
+                        logger->flush_on(spdlog::level::from_str(flush_level));
+                    }
+                    // replaces the logger configured before, or left by Shutdown()
+                    if(logger_id != logger_count_ || released_loggers_.erase(logger_name) > 0){
+                        spdlog::drop(logger_name);
+                    }
                     spdlog::register_logger(logger);
 
-                    logger_table_[logger_count_] = GetLogger(logger_name);
-                    if(!SetLoggerId(logger_name, logger_count_)){
-                        return false;
+                    logger_table_[logger_id] = GetLogger(logger_name);
+                    if(logger_id == logger_count_){
+                        if(!SetLoggerId(logger_name, logger_id)){
+                            return false;
+                        }
+                        logger_count_++;
                     }
-                    logger_count_++;
 
                     logger->info("Logger started");
                 }
@@ -449,6 +990,50 @@ private:
             }
         }
 
+        //
+        // Start the periodic flusher for the tracked sinks and the buffered sinks with a max delay
+        //
+        std::vector<std::shared_ptr<sinks::dirty_tracking_sink>> tracked_sinks;
+        std::vector<std::shared_ptr<sinks::buffered_sink>> buffered_sinks;
+        std::set<spdlog::sinks::sink*> found_sinks;    // a shared sink is found once per sharing sink
+        std::unordered_map<std::string, std::shared_ptr<spdlog::sinks::sink>>::iterator sink_it;
+        for(sink_it = sink_map_.begin(); sink_it != sink_map_.end(); sink_it++){
+            std::shared_ptr<sinks::dirty_tracking_sink> tracked =
+                FindWrappedSink<sinks::dirty_tracking_sink>(sink_it->second);
+            if(tracked != nullptr && found_sinks.insert(tracked.get()).second){
+                tracked_sinks.push_back(tracked);
+            }
+            std::shared_ptr<sinks::buffered_sink> buffered = FindWrappedSink<sinks::buffered_sink>(sink_it->second);
+            if(buffered != nullptr && buffered->max_delay().count() > 0 && found_sinks.insert(buffered.get()).second){
+                buffered_sinks.push_back(buffered);
+            }
+        }
+        if(!tracked_sinks.empty() || !buffered_sinks.empty()){
+            periodic_flusher_.reset(new details::periodic_flusher(
+                                        std::chrono::milliseconds(flush_interval_ms_), tracked_sinks, buffered_sinks));
+        }
+
+        //
+        // Publish the levels of the loggers in the level control file
+        //
+        if(!level_control_path.empty() && !OpenLevelControl(level_control_path)){
+            return false;
+        }
+
+        //
+        // Start the admin thread serving the commands of the admin socket
+        //
+        if(!admin_socket_path_.empty()){
+            try{
+                admin_server_.reset(new details::admin_server(admin_socket_path_,
+                    std::bind(&SpdlogJsonConfig::HandleAdminCommand, this, std::placeholders::_1)));
+            }
+            catch(const spdlog::spdlog_ex& ex){
+                printf("%s::%s: Start admin socket failure: %s\n", __CLASS__, __FUNCTION__, ex.what());
+                return false;
+            }
+        }
+
         return true;
     }
 
@@ -463,169 +1048,82 @@ private:
         }
 
         std::string sink_type(it->value.GetString());
-        if(supported_sink_type_.find(sink_type) == supported_sink_type_.end()){
-            printf("%s::%s: sink type '%s' not supported\n", __CLASS__, __FUNCTION__, sink_type.c_str());
+        std::shared_ptr<spdlog::sinks::sink> sink = CreateSink(sink_name, sink_type, value);
+        if(sink == nullptr){
             return false;
         }
 
-        if(sink_type == SINK_TYPE_STDOUT_SINK_ST){
-            sink_map_[sink_name] = std::make_shared<spdlog::sinks::stdout_sink_st>();
-        }
-        else if(sink_type == SINK_TYPE_STDOUT_SINK_MT){
-            sink_map_[sink_name] = std::make_shared<spdlog::sinks::stdout_sink_mt>();
-        }
-        else if (sink_type == SINK_TYPE_STDERR_SINK_ST){
-            sink_map_[sink_name] = std::make_shared<spdlog::sinks::stderr_sink_st>();
+        // Create the sink again on the reopen command of the admin socket, e.g. after logrotate.
+        // The command runs in the admin thread, so only thread safe (_mt) sinks are reopened.
+        if(!admin_socket_path_.empty() && IsThreadSafeSinkType(sink_type) && value.HasMember("file_name") &&
+           sink_type != SINK_TYPE_FLIGHT_RECORDER_SINK_MT){
+            std::shared_ptr<rapidjson::Document> reopen_config = std::make_shared<rapidjson::Document>();
+            reopen_config->CopyFrom(value, reopen_config->GetAllocator());
+            reopen_config->RemoveMember("truncate");    // append to the file if it was not moved
+            sink = std::make_shared<sinks::reopen_sink>(sink, [this, sink_name, sink_type, reopen_config](){
+                return CreateSink(sink_name, sink_type, *reopen_config);
+            });
         }
-        else if(sink_type == SINK_TYPE_STDERR_SINK_MT){
-            sink_map_[sink_name] = std::make_shared<spdlog::sinks::stderr_sink_mt>();
-        }
-        else if (sink_type == SINK_TYPE_STDOUT_COLOR_SINK_ST) {
-            sink_map_[sink_name] = std::make_shared<spdlog::sinks::stdout_color_sink_st>();
-        }
-        else if(sink_type == SINK_TYPE_STDOUT_COLOR_SINK_MT){
-            sink_map_[sink_name] = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
-        }
-        else if(sink_type == SINK_TYPE_STDERR_COLOR_SINK_ST){
-            sink_map_[sink_name] = std::make_shared<spdlog::sinks::stderr_color_sink_st>();
-        }
-        else if(sink_type == SINK_TYPE_STDERR_COLOR_SINK_MT){
-            sink_map_[sink_name] = std::make_shared<spdlog::sinks::stderr_color_sink_mt>();
-        }
-        else if(sink_type == SINK_TYPE_SYSLOG_SINK_ST ||
-                sink_type == SINK_TYPE_SYSLOG_SINK_MT){
+        sink_map_[sink_name] = sink;
 
-            std::string indent("");
-            it = value.FindMember("indent");
-            if(it != value.MemberEnd()){
-                indent = std::string(it->value.GetString());
-            }
+        // Write the records of the stdio file sinks in chunks of buffer_size bytes
+        if(IsStdioFileSinkType(sink_type)){
+            size_t   buffer_size = 0;
+            uint32_t max_buffer_delay_ms = 0;
 
-            if(sink_type == SINK_TYPE_SYSLOG_SINK_ST){
-                sink_map_[sink_name] = std::make_shared<spdlog::sinks::syslog_sink_st>(indent);
-            }
-            else {
-                // SINK_TYPE_SYSLOG_SINK_MT
-                sink_map_[sink_name] = std::make_shared<spdlog::sinks::syslog_sink_mt>(indent);
-            }
-        }
-        else if(sink_type == SINK_TYPE_BASIC_FILE_SINK_ST ||
-                sink_type == SINK_TYPE_BASIC_FILE_SINK_MT){
-            std::string file_name;
-            bool        truncate;
-
-            // mandatory configuration for daily file sink
-            it = value.FindMember("file_name");
-            if(it == value.MemberEnd()) file_name = std::string("./log_file.log");
-            else file_name = std::string(it->value.GetString());
-
-            it = value.FindMember("truncate");
-            if(it == value.MemberEnd()) truncate = false;
-            else truncate = it->value.GetBool();
-
-            char buffer[file_name.size() + 1];
-            strcpy(buffer, file_name.c_str());
-            char* dir_name = dirname(buffer);
-            if(strcmp(dir_name, ".") != 0){
-                if(!CreateDirectory(dir_name)){
-                    printf("%s::%s: Create directory '%s' failure\n", __CLASS__, __FUNCTION__, dir_name);
-                    return false;
-                }
-            }
+            it = value.FindMember("buffer_size");
+            if(it != value.MemberEnd()) buffer_size = it->value.GetUint64();
 
-            if(sink_type == SINK_TYPE_BASIC_FILE_SINK_ST){
-                sink_map_[sink_name] = std::make_shared<spdlog::sinks::basic_file_sink_st>(
-                                           file_name, truncate);
-            }
-            else {
-                // sink_type == SINK_TYPE_BASIC_FILE_SINK_MT
-                sink_map_[sink_name] = std::make_shared<spdlog::sinks::basic_file_sink_mt>(
-                                           file_name, truncate);
-            }
-
-        }
-        else if (sink_type == SINK_TYPE_DAILY_FILE_SINK_ST ||
-                 sink_type == SINK_TYPE_DAILY_FILE_SINK_MT) {
-            std::string base_file_name;
-            int32_t     rotation_hour;
-            int32_t     rotation_minute;
-            bool        truncate;
-
-            // mandatory configuration for daily file sink
-            it = value.FindMember("base_file_name");
-            if(it == value.MemberEnd()) base_file_name = std::string("./daily.log");
-            else base_file_name = std::string(it->value.GetString());
-
-            it = value.FindMember("rotation_hour");
-            if(it == value.MemberEnd()) rotation_hour = 0;
-            else rotation_hour = it->value.GetInt();
-
-            it = value.FindMember("rotation_minute");
-            if(it == value.MemberEnd()) rotation_minute = 0;
-            else rotation_minute = it->value.GetInt();
-
-            it = value.FindMember("truncate");
-            if(it == value.MemberEnd()) truncate = false;
-            else truncate = it->value.GetBool();
-
-            char buffer[base_file_name.size() + 1];
-            strcpy(buffer, base_file_name.c_str());
-            char* dir_name = dirname(buffer);
-            if(strcmp(dir_name, ".") != 0){
-                if(!CreateDirectory(dir_name)){
-                    printf("%s::%s: Create directory '%s' failure\n", __CLASS__, __FUNCTION__, dir_name);
-                    return false;
-                }
-            }
+            it = value.FindMember("max_buffer_delay_ms");
+            if(it != value.MemberEnd()) max_buffer_delay_ms = it->value.GetUint();
 
-            if(sink_type == SINK_TYPE_DAILY_FILE_SINK_ST){
-                sink_map_[sink_name] = std::make_shared<spdlog::sinks::daily_file_sink_st>(
-                                           base_file_name, rotation_hour, rotation_minute, truncate);
+            // A chunk is written to one file: keep it below the rotation size
+            it = value.FindMember("max_size");
+            if(it != value.MemberEnd() && buffer_size > it->value.GetUint64()){
+                printf("%s::%s: buffer_size of sink '%s' larger than max_size. Use max_size\n",
+                       __CLASS__, __FUNCTION__, sink_name.c_str());
+                buffer_size = it->value.GetUint64();
             }
-            else {
-                // sink_type == SINK_TYPE_DAILY_FILE_SINK_MT
-                sink_map_[sink_name] = std::make_shared<spdlog::sinks::daily_file_sink_mt>(
-                                           base_file_name, rotation_hour, rotation_minute, truncate);
+
+            if(buffer_size > 0){
+                std::shared_ptr<sinks::buffered_sink> buffered = std::make_shared<sinks::buffered_sink>(
+                    sink_map_[sink_name], buffer_size, std::chrono::milliseconds(max_buffer_delay_ms));
+                if(sink_type == SINK_TYPE_DAILY_FILE_SINK_ST || sink_type == SINK_TYPE_DAILY_FILE_SINK_MT){
+                    int32_t rotation_hour = 0;
+                    int32_t rotation_minute = 0;
+                    it = value.FindMember("rotation_hour");
+                    if(it != value.MemberEnd()) rotation_hour = it->value.GetInt();
+                    it = value.FindMember("rotation_minute");
+                    if(it != value.MemberEnd()) rotation_minute = it->value.GetInt();
+                    buffered->set_daily_rotation(rotation_hour, rotation_minute);
+                }
+                sink_map_[sink_name] = buffered;
             }
         }
-        else if (sink_type == SINK_TYPE_ROTATING_FILE_SINK_ST ||
-                 sink_type == SINK_TYPE_ROTATING_FILE_SINK_MT) {
-            std::string base_file_name;
-            size_t      max_files;
-            size_t      max_size;
 
-            // mandatory configuration for daily file sink
-            it = value.FindMember("base_file_name");
-            if(it == value.MemberEnd()) base_file_name = std::string("./rotate.log");
-            else base_file_name = std::string(it->value.GetString());
-
-            it = value.FindMember("max_files");
-            if(it == value.MemberEnd()) max_files = 10;
-            else max_files = it->value.GetUint64();
+        // Drop the records beyond the rate limit of the sink
+        std::shared_ptr<details::rate_limiter> rate_limiter;
+        if(!ParseRateLimit(sink_name, value, rate_limiter)){
+            return false;
+        }
+        if(rate_limiter != nullptr){
+            sink_map_[sink_name] = std::make_shared<sinks::rate_limit_sink>(sink_map_[sink_name], rate_limiter, sink_name);
+        }
 
-            it = value.FindMember("max_size");
-            if(it == value.MemberEnd()) max_size = 1024 * 1024 * 10; // 10MB
-            else max_size = it->value.GetUint64();
-
-            char buffer[base_file_name.size() + 1];
-            strcpy(buffer, base_file_name.c_str());
-            char* dir_name = dirname(buffer);
-            if(strcmp(dir_name, ".") != 0){
-                if(!CreateDirectory(dir_name)){
-                    printf("%s::%s: Create directory '%s' failure\n", __CLASS__, __FUNCTION__, dir_name);
-                    return false;
-                }
-            }
+        // Collapse the consecutive identical records, before they take rate limit tokens
+        it = value.FindMember("dedup");
+        if(it != value.MemberEnd()){
+            uint32_t window_ms = 5000;
+            rapidjson::Value::ConstMemberIterator param_it = it->value.FindMember("window_ms");
+            if(param_it != it->value.MemberEnd()) window_ms = param_it->value.GetUint();
+            sink_map_[sink_name] = std::make_shared<sinks::dedup_sink>(sink_map_[sink_name],
+                                                                       std::chrono::milliseconds(window_ms));
+        }
 
-            if(sink_type == SINK_TYPE_ROTATING_FILE_SINK_ST){
-                sink_map_[sink_name] = std::make_shared<spdlog::sinks::rotating_file_sink_st>(
-                                           base_file_name, max_size, max_files);
-            }
-            else {
-                // SINK_TYPE_ROTATING_FILE_SINK_MT
-                sink_map_[sink_name] = std::make_shared<spdlog::sinks::rotating_file_sink_mt>(
-                                           base_file_name, max_size, max_files);
-            }
+        // Track writes so that the periodic flusher only flushes sinks written since its last tick.
+        // The flusher runs in its own thread, so only thread safe (_mt) sinks are tracked.
+        if(flush_interval_ms_ > 0 && IsThreadSafeSinkType(sink_type)){
+            sink_map_[sink_name] = std::make_shared<sinks::dirty_tracking_sink>(sink_map_[sink_name]);
         }
 
         // set level if any
@@ -635,34 +1133,1356 @@ private:
             sink_map_[sink_name]->set_level(spdlog::level::from_str(level));
         }
 
-        // set pattern if any
-        it = value.FindMember("pattern");
-        if(it != value.MemberEnd()){
-            std::unordered_map<std::string, std::string>::const_iterator pattern_it =
-                pattern_config.find(std::string(it->value.GetString()));
-            if(pattern_it != pattern_config.end()){
-                sink_map_[sink_name]->set_pattern(pattern_it->second);
-            }
+        // set pattern if any, it wins over the pattern of the loggers
+        std::string pattern = GetSinkPattern(value, pattern_config);
+        if(!pattern.empty()){
+            sink_map_[sink_name]->set_pattern(pattern);
         }
 
         return true;
     }
 
-    bool CreateDirectory(const char* dir_path){
-        struct stat st = {0};
-        if(stat(dir_path, &st) == -1){
-            if (mkdir(dir_path, 0755) == -1) return false;
+    /// @brief  Load a plugin and call its entry point, once per file
+    ///
+    /// The library is not unloaded, even on failure: its entry point may have registered
+    /// some types before failing.
+    bool LoadPlugin(const std::string& path){
+        std::string canonical_path = GetCanonicalPath(path);
+        if(loaded_plugins_.count(canonical_path) > 0){
+            return true;
+        }
+
+        void* handle = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+        if(handle == nullptr){
+            printf("%s::%s: Load plugin '%s' failure: %s\n", __CLASS__, __FUNCTION__, path.c_str(), dlerror());
+            return false;
+        }
+
+        plugin_entry entry = reinterpret_cast<plugin_entry>(dlsym(handle, SPDLOG_JSON_CONFIG_PLUGIN_ENTRY_NAME));
+        if(entry == nullptr){
+            printf("%s::%s: Plugin '%s' has no entry point %s, built for another version?\n",
+                   __CLASS__, __FUNCTION__, path.c_str(), SPDLOG_JSON_CONFIG_PLUGIN_ENTRY_NAME);
+            dlclose(handle);
+            return false;
+        }
+
+        loaded_plugins_.insert(canonical_path);
+        if(!entry(this)){
+            printf("%s::%s: Plugin '%s' registration failure\n", __CLASS__, __FUNCTION__, path.c_str());
+            return false;
         }
         return true;
     }
 
-    std::shared_ptr<spdlog::logger>
-    CreateSync(const std::string& logger_name,
-               std::vector<std::shared_ptr<spdlog::sinks::sink>>& sink_list){
-        auto new_logger = std::make_shared<spdlog::logger>(std::move(logger_name),
-                                                               begin(sink_list), end(sink_list));
-            //spdlog::details::registry::instance().register_and_init(new_logger);
-            return new_logger;
+    /// @brief  Create a sink with the factory of its type, wrapped in a fadvise_sink if configured
+    ///
+    /// @return the sink, nullptr on failure
+    std::shared_ptr<spdlog::sinks::sink> CreateSink(const std::string& sink_name, const std::string& sink_type,
+                                                    const rapidjson::Value& value){
+        std::unordered_map<std::string, SinkFactory>::iterator factory_it = sink_factories_.find(sink_type);
+        if(factory_it == sink_factories_.end()){
+            printf("%s::%s: sink type '%s' not supported\n", __CLASS__, __FUNCTION__, sink_type.c_str());
+            return nullptr;
+        }
+        std::shared_ptr<spdlog::sinks::sink> sink = factory_it->second(sink_name, sink_type, value);
+        if(sink == nullptr){
+            printf("%s::%s: Create sink '%s' of type '%s' failure\n",
+                   __CLASS__, __FUNCTION__, sink_name.c_str(), sink_type.c_str());
+            return nullptr;
+        }
+
+        // Drop the pages of the stdio buffered file sinks from the page cache on flush
+        rapidjson::Value::ConstMemberIterator it = value.FindMember("fadvise");
+        if(it != value.MemberEnd()){
+            std::string advice(it->value.GetString());
+            if(advice != "dontneed"){
+                printf("%s::%s: fadvise '%s' of sink '%s' not supported\n",
+                       __CLASS__, __FUNCTION__, advice.c_str(), sink_name.c_str());
+                return nullptr;
+            }
+            if(!WrapFadviseSink<spdlog::sinks::basic_file_sink_st>(sink) &&
+               !WrapFadviseSink<spdlog::sinks::basic_file_sink_mt>(sink) &&
+               !WrapFadviseSink<spdlog::sinks::daily_file_sink_st>(sink) &&
+               !WrapFadviseSink<spdlog::sinks::daily_file_sink_mt>(sink) &&
+               !WrapFadviseSink<spdlog::sinks::rotating_file_sink_st>(sink) &&
+               !WrapFadviseSink<spdlog::sinks::rotating_file_sink_mt>(sink)){
+                printf("%s::%s: fadvise not supported by type '%s' of sink '%s'\n",
+                       __CLASS__, __FUNCTION__, sink_type.c_str(), sink_name.c_str());
+                return nullptr;
+            }
+        }
+        return sink;
+    }
+
+    /// @brief  Get the factory calling a member function of the instance
+    SinkFactory BindSinkFactory(std::shared_ptr<spdlog::sinks::sink> (SpdlogJsonConfig::*create)(
+                                    const std::string&, const std::string&, const rapidjson::Value&)){
+        return std::bind(create, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3);
+    }
+
+    template<typename ConsoleSink>
+    static std::shared_ptr<spdlog::sinks::sink> CreateConsoleSink(const std::string& sink_name,
+                                                                  const std::string& sink_type,
+                                                                  const rapidjson::Value& value){
+        return std::make_shared<ConsoleSink>();
+    }
+
+    /// @brief  Create a syslog sink
+    std::shared_ptr<spdlog::sinks::sink> CreateSyslogSink(const std::string& sink_name, const std::string& sink_type,
+                                                          const rapidjson::Value& value){
+        rapidjson::Value::ConstMemberIterator it;
+        std::string indent("");
+        it = value.FindMember("indent");
+        if(it != value.MemberEnd()){
+            indent = std::string(it->value.GetString());
+        }
+
+        if(sink_type == SINK_TYPE_SYSLOG_SINK_ST){
+            return std::make_shared<spdlog::sinks::syslog_sink_st>(indent);
+        }
+        else {
+            // SINK_TYPE_SYSLOG_SINK_MT
+            return std::make_shared<spdlog::sinks::syslog_sink_mt>(indent);
+        }
+    }
+
+    /// @brief  Create a basic file sink
+    std::shared_ptr<spdlog::sinks::sink> CreateBasicFileSink(const std::string& sink_name, const std::string& sink_type,
+                                                             const rapidjson::Value& value){
+        rapidjson::Value::ConstMemberIterator it;
+        std::string file_name;
+        bool        truncate;
+
+        // mandatory configuration for daily file sink
+        it = value.FindMember("file_name");
+        if(it == value.MemberEnd()) file_name = std::string("./log_file.log");
+        else file_name = std::string(it->value.GetString());
+
+        it = value.FindMember("truncate");
+        if(it == value.MemberEnd()) truncate = false;
+        else truncate = it->value.GetBool();
+
+        char buffer[file_name.size() + 1];
+        strcpy(buffer, file_name.c_str());
+        char* dir_name = dirname(buffer);
+        if(strcmp(dir_name, ".") != 0){
+            if(!CreateDirectory(dir_name)){
+                printf("%s::%s: Create directory '%s' failure\n", __CLASS__, __FUNCTION__, dir_name);
+                return nullptr;
+            }
+        }
+
+        if(sink_type == SINK_TYPE_BASIC_FILE_SINK_ST){
+            return std::make_shared<spdlog::sinks::basic_file_sink_st>(
+                       file_name, truncate);
+        }
+        else {
+            // sink_type == SINK_TYPE_BASIC_FILE_SINK_MT
+            return std::make_shared<spdlog::sinks::basic_file_sink_mt>(
+                       file_name, truncate);
+        }
+    }
+
+    /// @brief  Create a daily file sink
+    std::shared_ptr<spdlog::sinks::sink> CreateDailyFileSink(const std::string& sink_name, const std::string& sink_type,
+                                                             const rapidjson::Value& value){
+        rapidjson::Value::ConstMemberIterator it;
+        std::string base_file_name;
+        int32_t     rotation_hour;
+        int32_t     rotation_minute;
+        bool        truncate;
+
+        // mandatory configuration for daily file sink
+        it = value.FindMember("base_file_name");
+        if(it == value.MemberEnd()) base_file_name = std::string("./daily.log");
+        else base_file_name = std::string(it->value.GetString());
+
+        it = value.FindMember("rotation_hour");
+        if(it == value.MemberEnd()) rotation_hour = 0;
+        else rotation_hour = it->value.GetInt();
+
+        it = value.FindMember("rotation_minute");
+        if(it == value.MemberEnd()) rotation_minute = 0;
+        else rotation_minute = it->value.GetInt();
+
+        it = value.FindMember("truncate");
+        if(it == value.MemberEnd()) truncate = false;
+        else truncate = it->value.GetBool();
+
+        char buffer[base_file_name.size() + 1];
+        strcpy(buffer, base_file_name.c_str());
+        char* dir_name = dirname(buffer);
+        if(strcmp(dir_name, ".") != 0){
+            if(!CreateDirectory(dir_name)){
+                printf("%s::%s: Create directory '%s' failure\n", __CLASS__, __FUNCTION__, dir_name);
+                return nullptr;
+            }
+        }
+
+        // Compress the file of the previous day in background
+        bool                     compress;
+        details::compress_format compress_format;
+        int                      compress_level;
+        if(!ParseCompress(sink_name, value, compress, compress_format, compress_level)){
+            return nullptr;
+        }
+        spdlog::file_event_handlers event_handlers;
+        if(compress){
+            event_handlers = std::make_shared<details::daily_archive>(
+                                 compress_format, compress_level, GetCompressor())->event_handlers();
+        }
+
+        if(sink_type == SINK_TYPE_DAILY_FILE_SINK_ST){
+            return std::make_shared<spdlog::sinks::daily_file_sink_st>(
+                       base_file_name, rotation_hour, rotation_minute, truncate, 0, event_handlers);
+        }
+        else {
+            // sink_type == SINK_TYPE_DAILY_FILE_SINK_MT
+            return std::make_shared<spdlog::sinks::daily_file_sink_mt>(
+                       base_file_name, rotation_hour, rotation_minute, truncate, 0, event_handlers);
+        }
+    }
+
+    /// @brief  Create a rotating file sink
+    std::shared_ptr<spdlog::sinks::sink> CreateRotatingFileSink(const std::string& sink_name, const std::string& sink_type,
+                                                                const rapidjson::Value& value){
+        rapidjson::Value::ConstMemberIterator it;
+        std::string base_file_name;
+        size_t      max_files;
+        size_t      max_size;
+
+        // mandatory configuration for daily file sink
+        it = value.FindMember("base_file_name");
+        if(it == value.MemberEnd()) base_file_name = std::string("./rotate.log");
+        else base_file_name = std::string(it->value.GetString());
+
+        it = value.FindMember("max_files");
+        if(it == value.MemberEnd()) max_files = 10;
+        else max_files = it->value.GetUint64();
+
+        it = value.FindMember("max_size");
+        if(it == value.MemberEnd()) max_size = 1024 * 1024 * 10; // 10MB
+        else max_size = it->value.GetUint64();
+
+        char buffer[base_file_name.size() + 1];
+        strcpy(buffer, base_file_name.c_str());
+        char* dir_name = dirname(buffer);
+        if(strcmp(dir_name, ".") != 0){
+            if(!CreateDirectory(dir_name)){
+                printf("%s::%s: Create directory '%s' failure\n", __CLASS__, __FUNCTION__, dir_name);
+                return nullptr;
+            }
+        }
+
+        // Compress the rotated files in background, keep max_files compressed files
+        bool                     compress;
+        details::compress_format compress_format;
+        int                      compress_level;
+        if(!ParseCompress(sink_name, value, compress, compress_format, compress_level)){
+            return nullptr;
+        }
+        spdlog::file_event_handlers event_handlers;
+        if(compress){
+            if(max_files == 0){
+                printf("%s::%s: compress of sink '%s' needs max_files > 0\n", __CLASS__, __FUNCTION__, sink_name.c_str());
+                return nullptr;
+            }
+            event_handlers = std::make_shared<details::rotating_archive>(
+                                 compress_format, compress_level, base_file_name, max_files,
+                                 GetCompressor())->event_handlers();
+        }
+
+        if(sink_type == SINK_TYPE_ROTATING_FILE_SINK_ST){
+            return std::make_shared<spdlog::sinks::rotating_file_sink_st>(
+                       base_file_name, max_size, max_files, false, event_handlers);
+        }
+        else {
+            // SINK_TYPE_ROTATING_FILE_SINK_MT
+            return std::make_shared<spdlog::sinks::rotating_file_sink_mt>(
+                       base_file_name, max_size, max_files, false, event_handlers);
+        }
+    }
+
+    /// @brief  Create a mmap file sink
+    std::shared_ptr<spdlog::sinks::sink> CreateMmapFileSink(const std::string& sink_name, const std::string& sink_type,
+                                                            const rapidjson::Value& value){
+        rapidjson::Value::ConstMemberIterator it;
+        std::string          file_name;
+        bool                 truncate;
+        size_t               window_size;
+        sinks::msync_policy  policy;
+
+        it = value.FindMember("file_name");
+        if(it == value.MemberEnd()) file_name = std::string("./mmap.log");
+        else file_name = std::string(it->value.GetString());
+
+        it = value.FindMember("truncate");
+        if(it == value.MemberEnd()) truncate = false;
+        else truncate = it->value.GetBool();
+
+        it = value.FindMember("window_size");
+        if(it == value.MemberEnd()) window_size = 1024 * 1024 * 16; // 16MB
+        else window_size = it->value.GetUint64();
+
+        policy = sinks::msync_policy::async;
+        it = value.FindMember("msync");
+        if(it != value.MemberEnd()){
+            std::string msync(it->value.GetString());
+            if(msync == "none") policy = sinks::msync_policy::none;
+            else if(msync == "async") policy = sinks::msync_policy::async;
+            else if(msync == "sync") policy = sinks::msync_policy::sync;
+            else {
+                printf("%s::%s: msync '%s' of sink '%s' not supported\n",
+                       __CLASS__, __FUNCTION__, msync.c_str(), sink_name.c_str());
+                return nullptr;
+            }
+        }
+
+        char buffer[file_name.size() + 1];
+        strcpy(buffer, file_name.c_str());
+        char* dir_name = dirname(buffer);
+        if(strcmp(dir_name, ".") != 0){
+            if(!CreateDirectory(dir_name)){
+                printf("%s::%s: Create directory '%s' failure\n", __CLASS__, __FUNCTION__, dir_name);
+                return nullptr;
+            }
+        }
+
+        if(sink_type == SINK_TYPE_MMAP_FILE_SINK_ST){
+            return std::make_shared<sinks::mmap_file_sink_st>(
+                       file_name, truncate, window_size, policy);
+        }
+        else {
+            // SINK_TYPE_MMAP_FILE_SINK_MT
+            return std::make_shared<sinks::mmap_file_sink_mt>(
+                       file_name, truncate, window_size, policy);
+        }
+    }
+
+    /// @brief  Create an io_uring file sink
+    std::shared_ptr<spdlog::sinks::sink> CreateIoUringFileSink(const std::string& sink_name, const std::string& sink_type,
+                                                               const rapidjson::Value& value){
+        rapidjson::Value::ConstMemberIterator it;
+        std::string file_name;
+        bool        truncate;
+        uint32_t    queue_depth;
+        size_t      buffer_size;
+
+        it = value.FindMember("file_name");
+        if(it == value.MemberEnd()) file_name = std::string("./io_uring.log");
+        else file_name = std::string(it->value.GetString());
+
+        it = value.FindMember("truncate");
+        if(it == value.MemberEnd()) truncate = false;
+        else truncate = it->value.GetBool();
+
+        it = value.FindMember("queue_depth");
+        if(it == value.MemberEnd()) queue_depth = 8;
+        else queue_depth = it->value.GetUint();
+
+        it = value.FindMember("buffer_size");
+        if(it == value.MemberEnd()) buffer_size = 256 * 1024; // 256KB
+        else buffer_size = it->value.GetUint64();
+
+        char buffer[file_name.size() + 1];
+        strcpy(buffer, file_name.c_str());
+        char* dir_name = dirname(buffer);
+        if(strcmp(dir_name, ".") != 0){
+            if(!CreateDirectory(dir_name)){
+                printf("%s::%s: Create directory '%s' failure\n", __CLASS__, __FUNCTION__, dir_name);
+                return nullptr;
+            }
+        }
+
+        if(sink_type == SINK_TYPE_IO_URING_FILE_SINK_ST){
+            return std::make_shared<sinks::io_uring_file_sink_st>(
+                       file_name, truncate, queue_depth, buffer_size);
+        }
+        else {
+            // SINK_TYPE_IO_URING_FILE_SINK_MT
+            return std::make_shared<sinks::io_uring_file_sink_mt>(
+                       file_name, truncate, queue_depth, buffer_size);
+        }
+    }
+
+    /// @brief  Create an O_DIRECT file sink
+    std::shared_ptr<spdlog::sinks::sink> CreateDirectFileSink(const std::string& sink_name, const std::string& sink_type,
+                                                              const rapidjson::Value& value){
+        rapidjson::Value::ConstMemberIterator it;
+        std::string file_name;
+        bool        truncate;
+        size_t      buffer_size;
+
+        it = value.FindMember("file_name");
+        if(it == value.MemberEnd()) file_name = std::string("./direct.log");
+        else file_name = std::string(it->value.GetString());
+
+        it = value.FindMember("truncate");
+        if(it == value.MemberEnd()) truncate = false;
+        else truncate = it->value.GetBool();
+
+        it = value.FindMember("buffer_size");
+        if(it == value.MemberEnd()) buffer_size = 1024 * 1024; // 1MB
+        else buffer_size = it->value.GetUint64();
+
+        char buffer[file_name.size() + 1];
+        strcpy(buffer, file_name.c_str());
+        char* dir_name = dirname(buffer);
+        if(strcmp(dir_name, ".") != 0){
+            if(!CreateDirectory(dir_name)){
+                printf("%s::%s: Create directory '%s' failure\n", __CLASS__, __FUNCTION__, dir_name);
+                return nullptr;
+            }
+        }
+
+        if(sink_type == SINK_TYPE_DIRECT_FILE_SINK_ST){
+            return std::make_shared<sinks::direct_file_sink_st>(
+                       file_name, truncate, buffer_size);
+        }
+        else {
+            // SINK_TYPE_DIRECT_FILE_SINK_MT
+            return std::make_shared<sinks::direct_file_sink_mt>(
+                       file_name, truncate, buffer_size);
+        }
+    }
+
+    /// @brief  Create a compressed file sink
+    std::shared_ptr<spdlog::sinks::sink> CreateCompressedFileSink(const std::string& sink_name, const std::string& sink_type,
+                                                                  const rapidjson::Value& value){
+        rapidjson::Value::ConstMemberIterator it;
+        std::string file_name;
+        bool        truncate;
+        size_t      frame_size;
+
+        it = value.FindMember("file_name");
+        if(it == value.MemberEnd()) file_name = std::string("./compressed.log.gz");
+        else file_name = std::string(it->value.GetString());
+
+        it = value.FindMember("truncate");
+        if(it == value.MemberEnd()) truncate = false;
+        else truncate = it->value.GetBool();
+
+        it = value.FindMember("frame_size");
+        if(it == value.MemberEnd()) frame_size = 256 * 1024; // 256KB
+        else frame_size = it->value.GetUint64();
+
+        // Optional "compress": {"format", "level"}, gzip by default
+        bool                     compress;
+        details::compress_format compress_format;
+        int                      compress_level;
+        if(!ParseCompress(sink_name, value, compress, compress_format, compress_level)){
+            return nullptr;
+        }
+
+        char buffer[file_name.size() + 1];
+        strcpy(buffer, file_name.c_str());
+        char* dir_name = dirname(buffer);
+        if(strcmp(dir_name, ".") != 0){
+            if(!CreateDirectory(dir_name)){
+                printf("%s::%s: Create directory '%s' failure\n", __CLASS__, __FUNCTION__, dir_name);
+                return nullptr;
+            }
+        }
+
+        if(sink_type == SINK_TYPE_COMPRESSED_FILE_SINK_ST){
+            return std::make_shared<sinks::compressed_file_sink_st>(
+                       file_name, truncate, frame_size, compress_format, compress_level);
+        }
+        else {
+            // SINK_TYPE_COMPRESSED_FILE_SINK_MT
+            return std::make_shared<sinks::compressed_file_sink_mt>(
+                       file_name, truncate, frame_size, compress_format, compress_level);
+        }
+    }
+
+    /// @brief  Create a binary file sink
+    std::shared_ptr<spdlog::sinks::sink> CreateBinaryFileSink(const std::string& sink_name, const std::string& sink_type,
+                                                              const rapidjson::Value& value){
+        rapidjson::Value::ConstMemberIterator it;
+        std::string file_name;
+        bool        truncate;
+
+        it = value.FindMember("file_name");
+        if(it == value.MemberEnd()) file_name = std::string("./binary.log");
+        else file_name = std::string(it->value.GetString());
+
+        it = value.FindMember("truncate");
+        if(it == value.MemberEnd()) truncate = false;
+        else truncate = it->value.GetBool();
+
+        char buffer[file_name.size() + 1];
+        strcpy(buffer, file_name.c_str());
+        char* dir_name = dirname(buffer);
+        if(strcmp(dir_name, ".") != 0){
+            if(!CreateDirectory(dir_name)){
+                printf("%s::%s: Create directory '%s' failure\n", __CLASS__, __FUNCTION__, dir_name);
+                return nullptr;
+            }
+        }
+
+        if(sink_type == SINK_TYPE_BINARY_FILE_SINK_ST){
+            return std::make_shared<sinks::binary_file_sink_st>(file_name, truncate);
+        }
+        else {
+            // SINK_TYPE_BINARY_FILE_SINK_MT
+            return std::make_shared<sinks::binary_file_sink_mt>(file_name, truncate);
+        }
+    }
+
+    /// @brief  Create a flight recorder sink
+    std::shared_ptr<spdlog::sinks::sink> CreateFlightRecorderSink(const std::string& sink_name, const std::string& sink_type,
+                                                                  const rapidjson::Value& value){
+        rapidjson::Value::ConstMemberIterator it;
+        std::string file_name;
+        size_t      ring_size;
+        bool        truncate;
+
+        it = value.FindMember("file_name");
+        if(it == value.MemberEnd()) file_name = std::string("/dev/shm/spdlog_flight_recorder");
+        else file_name = std::string(it->value.GetString());
+
+        it = value.FindMember("ring_size");
+        if(it == value.MemberEnd()) ring_size = 64 * 1024 * 1024; // 64MB
+        else ring_size = it->value.GetUint64();
+
+        it = value.FindMember("truncate");
+        if(it == value.MemberEnd()) truncate = false;
+        else truncate = it->value.GetBool();
+
+        char buffer[file_name.size() + 1];
+        strcpy(buffer, file_name.c_str());
+        char* dir_name = dirname(buffer);
+        if(strcmp(dir_name, ".") != 0){
+            if(!CreateDirectory(dir_name)){
+                printf("%s::%s: Create directory '%s' failure\n", __CLASS__, __FUNCTION__, dir_name);
+                return nullptr;
+            }
+        }
+
+        if(sink_type == SINK_TYPE_FLIGHT_RECORDER_SINK_ST){
+            return std::make_shared<sinks::flight_recorder_sink_st>(file_name, ring_size, truncate);
+        }
+        else {
+            // SINK_TYPE_FLIGHT_RECORDER_SINK_MT
+            return std::make_shared<sinks::flight_recorder_sink_mt>(file_name, ring_size, truncate);
+        }
+    }
+
+    /// @brief  Create a unix socket sink
+    std::shared_ptr<spdlog::sinks::sink> CreateUnixSocketSink(const std::string& sink_name, const std::string& sink_type,
+                                                              const rapidjson::Value& value){
+        rapidjson::Value::ConstMemberIterator it;
+        std::string             socket_path;
+        sinks::unix_socket_type socket_type = sinks::unix_socket_type::stream;
+        size_t                  batch_size;
+        size_t                  buffer_size;
+        uint32_t                reconnect_min_ms;
+        uint32_t                reconnect_max_ms;
+
+        it = value.FindMember("socket_path");
+        if(it == value.MemberEnd()){
+            printf("%s::%s: No socket_path defined for sink '%s'\n", __CLASS__, __FUNCTION__, sink_name.c_str());
+            return nullptr;
+        }
+        socket_path = std::string(it->value.GetString());
+
+        it = value.FindMember("socket_type");
+        if(it != value.MemberEnd()){
+            std::string type_name(it->value.GetString());
+            if(type_name == "stream") socket_type = sinks::unix_socket_type::stream;
+            else if(type_name == "dgram") socket_type = sinks::unix_socket_type::dgram;
+            else {
+                printf("%s::%s: socket_type '%s' of sink '%s' not supported\n",
+                       __CLASS__, __FUNCTION__, type_name.c_str(), sink_name.c_str());
+                return nullptr;
+            }
+        }
+
+        it = value.FindMember("batch_size");
+        if(it == value.MemberEnd()) batch_size = 64;
+        else batch_size = it->value.GetUint64();
+
+        it = value.FindMember("buffer_size");
+        if(it == value.MemberEnd()) buffer_size = 4 * 1024 * 1024; // 4MB
+        else buffer_size = it->value.GetUint64();
+
+        it = value.FindMember("reconnect_min_ms");
+        if(it == value.MemberEnd()) reconnect_min_ms = 100;
+        else reconnect_min_ms = it->value.GetUint();
+
+        it = value.FindMember("reconnect_max_ms");
+        if(it == value.MemberEnd()) reconnect_max_ms = 5000;
+        else reconnect_max_ms = it->value.GetUint();
+
+        if(sink_type == SINK_TYPE_UNIX_SOCKET_SINK_ST){
+            return std::make_shared<sinks::unix_socket_sink_st>(
+                       socket_path, socket_type, batch_size, buffer_size,
+                       std::chrono::milliseconds(reconnect_min_ms),
+                       std::chrono::milliseconds(reconnect_max_ms));
+        }
+        else {
+            // SINK_TYPE_UNIX_SOCKET_SINK_MT
+            return std::make_shared<sinks::unix_socket_sink_mt>(
+                       socket_path, socket_type, batch_size, buffer_size,
+                       std::chrono::milliseconds(reconnect_min_ms),
+                       std::chrono::milliseconds(reconnect_max_ms));
+        }
+    }
+
+    /// @brief  Create a sharded file sink
+    std::shared_ptr<spdlog::sinks::sink> CreateShardedFileSink(const std::string& sink_name, const std::string& sink_type,
+                                                               const rapidjson::Value& value){
+        rapidjson::Value::ConstMemberIterator it;
+        std::string base_file_name;
+        bool        truncate;
+        size_t      buffer_size;
+
+        it = value.FindMember("base_file_name");
+        if(it == value.MemberEnd()) base_file_name = std::string("./sharded-{tid}.log");
+        else base_file_name = std::string(it->value.GetString());
+
+        it = value.FindMember("truncate");
+        if(it == value.MemberEnd()) truncate = false;
+        else truncate = it->value.GetBool();
+
+        it = value.FindMember("buffer_size");
+        if(it == value.MemberEnd()) buffer_size = 64 * 1024; // 64KB
+        else buffer_size = it->value.GetUint64();
+
+        char buffer[base_file_name.size() + 1];
+        strcpy(buffer, base_file_name.c_str());
+        char* dir_name = dirname(buffer);
+        if(strcmp(dir_name, ".") != 0){
+            if(!CreateDirectory(dir_name)){
+                printf("%s::%s: Create directory '%s' failure\n", __CLASS__, __FUNCTION__, dir_name);
+                return nullptr;
+            }
+        }
+
+        return std::make_shared<sinks::sharded_file_sink>(base_file_name, truncate, buffer_size);
+    }
+
+    /// @brief  Generate the sinks writing the same file
+    ///
+    /// The sink of the owner writes the file. Each sharing sink, the owner included, is a
+    /// proxy to it holding its own level. The configurations differ by the level only.
+    ///
+    /// @param  owner       name of the sink generated for all of them
+    /// @param  sink_owner  owner of every sharing sink, by name
+    bool GenerateSharedSinks(const std::string& owner,
+                             const std::unordered_map<std::string, std::string>& sink_owner,
+                             std::unordered_map<std::string, rapidjson::Value>& sink_config,
+                             const std::unordered_map<std::string, std::string>& pattern_config){
+        if(!GenerateSink(owner, sink_config[owner], pattern_config)){
+            return false;
+        }
+        // The proxy of the owner first: it takes the level of the sink
+        std::shared_ptr<spdlog::sinks::sink> writer = sink_map_[owner];
+        sink_map_[owner] = std::make_shared<sinks::proxy_sink>(writer);
+        std::unordered_map<std::string, std::string>::const_iterator it;
+        for(it = sink_owner.begin(); it != sink_owner.end(); it++){
+            if(it->second != owner || it->first == owner){
+                continue;
+            }
+            std::shared_ptr<spdlog::sinks::sink> proxy = std::make_shared<sinks::proxy_sink>(writer);
+            rapidjson::Value::ConstMemberIterator level_it = sink_config[it->first].FindMember("level");
+            if(level_it != sink_config[it->first].MemberEnd()){
+                proxy->set_level(spdlog::level::from_str(std::string(level_it->value.GetString())));
+            }
+            sink_map_[it->first] = proxy;
+        }
+        return true;
+    }
+
+    /// @brief  Find the sinks writing the same file, by canonical path of file_name or base_file_name
+    ///
+    /// The sinks of a file may differ by their level only, otherwise the configuration is
+    /// rejected: two sinks opening the file would interleave their writes.
+    ///
+    /// @param  sink_config  the configuration of the sinks by name
+    /// @param  sink_owner   set to the owner of every sharing sink, the smallest name of its file
+    /// @return false if sinks of a file differ
+    bool FindSharedSinks(const std::unordered_map<std::string, rapidjson::Value>& sink_config,
+                         std::unordered_map<std::string, std::string>& sink_owner){
+        std::map<std::string, std::set<std::string>> file_sinks;
+        std::unordered_map<std::string, rapidjson::Value>::const_iterator it;
+        for(it = sink_config.begin(); it != sink_config.end(); it++){
+            if(!it->second.IsObject()){
+                continue;
+            }
+            rapidjson::Value::ConstMemberIterator file_it = it->second.FindMember("file_name");
+            if(file_it == it->second.MemberEnd()){
+                file_it = it->second.FindMember("base_file_name");
+            }
+            if(file_it != it->second.MemberEnd()){
+                file_sinks[GetCanonicalPath(file_it->value.GetString())].insert(it->first);
+            }
+        }
+
+        std::map<std::string, std::set<std::string>>::iterator file_it;
+        for(file_it = file_sinks.begin(); file_it != file_sinks.end(); file_it++){
+            if(file_it->second.size() < 2){
+                continue;
+            }
+            const std::string& owner = *file_it->second.begin();
+            std::set<std::string>::iterator name_it;
+            for(name_it = file_it->second.begin(); name_it != file_it->second.end(); name_it++){
+                if(!SameSinkConfig(sink_config.at(owner), sink_config.at(*name_it))){
+                    printf("%s::%s: sinks '%s' and '%s' write the same file '%s' with different configurations\n",
+                           __CLASS__, __FUNCTION__, owner.c_str(), name_it->c_str(), file_it->first.c_str());
+                    return false;
+                }
+                sink_owner[*name_it] = owner;
+            }
+        }
+        return true;
+    }
+
+    /// @brief  Whether two sink configurations of the same file are the same but for the level
+    ///
+    /// The paths, equal once canonical, may be written differently.
+    static bool SameSinkConfig(const rapidjson::Value& a, const rapidjson::Value& b){
+        static const char* ignored[] = {"level", "file_name", "base_file_name"};
+        unsigned count = 0;
+        unsigned other_count = b.MemberCount();
+        for(const char* name : ignored){
+            if(b.HasMember(name)) other_count--;
+        }
+        rapidjson::Value::ConstMemberIterator it;
+        for(it = a.MemberBegin(); it != a.MemberEnd(); it++){
+            bool skip = false;
+            for(const char* name : ignored){
+                skip = skip || strcmp(it->name.GetString(), name) == 0;
+            }
+            if(skip){
+                continue;
+            }
+            rapidjson::Value::ConstMemberIterator other = b.FindMember(it->name.GetString());
+            if(other == b.MemberEnd() || other->value != it->value){
+                return false;
+            }
+            count++;
+        }
+        return count == other_count;
+    }
+
+    /// @brief  Get the absolute path of a file, with the symbolic links resolved
+    ///
+    /// The file or its directory may not exist yet: the path is then normalized as text.
+    static std::string GetCanonicalPath(const std::string& path){
+        char resolved[PATH_MAX];
+        if(realpath(path.c_str(), resolved) != nullptr){
+            return std::string(resolved);
+        }
+        size_t slash = path.rfind('/');
+        std::string dir_name = (slash == std::string::npos) ? std::string(".") : path.substr(0, slash + 1);
+        std::string base_name = (slash == std::string::npos) ? path : path.substr(slash + 1);
+        if(realpath(dir_name.c_str(), resolved) != nullptr){
+            return std::string(resolved) + "/" + base_name;
+        }
+
+        std::string absolute = path;
+        if(absolute.empty() || absolute[0] != '/'){
+            char cwd[PATH_MAX];
+            if(getcwd(cwd, sizeof(cwd)) != nullptr){
+                absolute = std::string(cwd) + "/" + path;
+            }
+        }
+        std::vector<std::string> parts;
+        size_t start = 0;
+        while(start <= absolute.size()){
+            size_t end = absolute.find('/', start);
+            if(end == std::string::npos) end = absolute.size();
+            std::string part = absolute.substr(start, end - start);
+            if(part == ".."){
+                if(!parts.empty()) parts.pop_back();
+            }
+            else if(!part.empty() && part != "."){
+                parts.push_back(part);
+            }
+            start = end + 1;
+        }
+        std::string canonical;
+        for(size_t i = 0; i < parts.size(); i++){
+            canonical += "/" + parts[i];
+        }
+        return canonical.empty() ? std::string("/") : canonical;
+    }
+
+    /// @brief  Group the loggers which share sinks, directly or through other loggers
+    ///
+    /// The sinks writing the same file are one sink: a sink is replaced by its owner.
+    ///
+    /// @param  loggers_config  the LOGGERS configuration
+    /// @param  sink_owner      the owner of every sharing sink, see FindSharedSinks()
+    /// @return map of logger name to the key of its group, i.e. the smallest sink name in the group
+    std::unordered_map<std::string, std::string> GroupLoggersBySinks(const rapidjson::Value& loggers_config,
+                                                                     const std::unordered_map<std::string, std::string>& sink_owner){
+        // union-find over the owner sink names. Loggers without sinks share the default sink.
+        std::unordered_map<std::string, std::string> parent;
+        std::unordered_map<std::string, std::string> first_sink;
+        rapidjson::Value::ConstMemberIterator it;
+        for(it = loggers_config.MemberBegin(); it != loggers_config.MemberEnd(); it++){
+            std::string logger_name(it->name.GetString());
+            std::string root(DEFAULT_LOGGER_NAME);
+            rapidjson::Value::ConstMemberIterator param_it = it->value.FindMember("sinks");
+            if(param_it != it->value.MemberEnd() && param_it->value.IsArray() && param_it->value.Size() > 0){
+                rapidjson::Value::ConstValueIterator value_it = param_it->value.Begin();
+                root = FindSinkGroup(parent, GetSinkOwner(sink_owner, value_it->GetString()));
+                for(value_it++; value_it != param_it->value.End(); value_it++){
+                    std::string other = FindSinkGroup(parent, GetSinkOwner(sink_owner, value_it->GetString()));
+                    if(other < root) std::swap(root, other);
+                    parent[other] = root;
+                }
+            }
+            parent.insert(std::make_pair(root, root));
+            first_sink[logger_name] = root;
+        }
+
+        std::unordered_map<std::string, std::string> groups;
+        std::unordered_map<std::string, std::string>::iterator group_it;
+        for(group_it = first_sink.begin(); group_it != first_sink.end(); group_it++){
+            groups[group_it->first] = FindSinkGroup(parent, group_it->second);
+        }
+        return groups;
+    }
+
+    /// @brief  Owner of the file of a sink, the sink itself if it doesn't share its file
+    static std::string GetSinkOwner(const std::unordered_map<std::string, std::string>& sink_owner,
+                                    const std::string& sink_name){
+        std::unordered_map<std::string, std::string>::const_iterator it = sink_owner.find(sink_name);
+        return (it == sink_owner.end()) ? sink_name : it->second;
+    }
+
+    /// @brief  Find the sinks to format once per record for all the sinks of a logger
+    ///
+    /// A sink is grouped if its type formats with the pattern and nothing wraps it which
+    /// writes records of its own or reads the payload (rate_limit, dedup), and if at least
+    /// one of its loggers has another such sink of the same pattern: the pattern of the
+    /// sink, or else the pattern of the logger.
+    ///
+    /// @param  loggers_config  the LOGGERS configuration
+    /// @param  sink_config     the configuration of the sinks by name
+    /// @param  pattern_config  the patterns by name
+    /// @return names of the sinks to group
+    std::set<std::string> FindFormatOnceSinks(const rapidjson::Value& loggers_config,
+                                              const std::unordered_map<std::string, rapidjson::Value>& sink_config,
+                                              const std::unordered_map<std::string, std::string>& pattern_config){
+        std::set<std::string> format_once_sinks;
+        rapidjson::Value::ConstMemberIterator it;
+        for(it = loggers_config.MemberBegin(); it != loggers_config.MemberEnd(); it++){
+            rapidjson::Value::ConstMemberIterator param_it = it->value.FindMember("sinks");
+            if(param_it == it->value.MemberEnd() || !param_it->value.IsArray()){
+                continue;
+            }
+            std::string logger_pattern = DEFAULT_PATTERN;
+            rapidjson::Value::ConstMemberIterator pattern_it = it->value.FindMember("pattern");
+            if(pattern_it != it->value.MemberEnd()){
+                std::unordered_map<std::string, std::string>::const_iterator found =
+                    pattern_config.find(std::string(pattern_it->value.GetString()));
+                if(found != pattern_config.end()) logger_pattern = found->second;
+            }
+
+            // candidates by pattern
+            std::map<std::string, std::vector<std::string>> candidates;
+            rapidjson::Value::ConstValueIterator value_it;
+            for(value_it = param_it->value.Begin(); value_it != param_it->value.End(); value_it++){
+                std::unordered_map<std::string, rapidjson::Value>::const_iterator sink_it =
+                    sink_config.find(value_it->GetString());
+                if(sink_it == sink_config.end() || !sink_it->second.IsObject()){
+                    continue;
+                }
+                const rapidjson::Value& value = sink_it->second;
+                rapidjson::Value::ConstMemberIterator type_it = value.FindMember("type");
+                if(type_it != value.MemberEnd() && IsFormatOnceSinkType(type_it->value.GetString()) &&
+                   !value.HasMember("rate_limit") && !value.HasMember("dedup")){
+                    std::string pattern = GetSinkPattern(value, pattern_config);
+                    candidates[pattern.empty() ? logger_pattern : pattern].push_back(sink_it->first);
+                }
+            }
+            std::map<std::string, std::vector<std::string>>::iterator candidate_it;
+            for(candidate_it = candidates.begin(); candidate_it != candidates.end(); candidate_it++){
+                if(candidate_it->second.size() > 1){
+                    format_once_sinks.insert(candidate_it->second.begin(), candidate_it->second.end());
+                }
+            }
+        }
+        return format_once_sinks;
+    }
+
+    /// @brief  Get the pattern configured for a sink
+    ///
+    /// @return the pattern text, empty if the sink has none or its pattern is not defined
+    static std::string GetSinkPattern(const rapidjson::Value& value,
+                                      const std::unordered_map<std::string, std::string>& pattern_config){
+        rapidjson::Value::ConstMemberIterator it = value.FindMember("pattern");
+        if(it == value.MemberEnd()){
+            return std::string();
+        }
+        std::unordered_map<std::string, std::string>::const_iterator pattern_it =
+            pattern_config.find(std::string(it->value.GetString()));
+        return pattern_it == pattern_config.end() ? std::string() : pattern_it->second;
+    }
+
+    static std::string GetSinkPattern(const std::string& sink_name,
+                                      const std::unordered_map<std::string, rapidjson::Value>& sink_config,
+                                      const std::unordered_map<std::string, std::string>& pattern_config){
+        std::unordered_map<std::string, rapidjson::Value>::const_iterator it = sink_config.find(sink_name);
+        return it == sink_config.end() ? std::string() : GetSinkPattern(it->second, pattern_config);
+    }
+
+    /// @brief  Wrap sink in a fadvise_sink if it is a FileSink
+    ///
+    /// @return true if sink was wrapped
+    template<typename FileSink>
+    static bool WrapFadviseSink(std::shared_ptr<spdlog::sinks::sink>& sink){
+        std::shared_ptr<FileSink> file_sink = std::dynamic_pointer_cast<FileSink>(sink);
+        if(file_sink == nullptr){
+            return false;
+        }
+        // The fadvise_sink owns the file sink
+        FileSink* file_sink_ptr = file_sink.get();
+        sink = std::make_shared<sinks::fadvise_sink>(sink, [file_sink_ptr](){
+            return std::string(file_sink_ptr->filename());
+        });
+        return true;
+    }
+
+    static std::string FindSinkGroup(std::unordered_map<std::string, std::string>& parent,
+                                     const std::string& sink_name){
+        std::unordered_map<std::string, std::string>::iterator it = parent.find(sink_name);
+        if(it == parent.end()){
+            parent[sink_name] = sink_name;
+            return sink_name;
+        }
+        if(it->second == sink_name){
+            return sink_name;
+        }
+        std::string root = FindSinkGroup(parent, it->second);
+        parent[sink_name] = root;
+        return root;
+    }
+
+    /// @brief  Run a command of the admin socket, in the admin thread
+    ///
+    /// The loggers and sinks are not reconfigured meanwhile: the admin thread is stopped
+    /// while they are.
+    ///
+    /// @param  command  the command line, words separated by spaces
+    /// @return the reply, lines ending with "OK" or "ERROR <reason>"
+    std::string HandleAdminCommand(const std::string& command){
+        std::vector<std::string> words;
+        size_t begin = command.find_first_not_of(' ');
+        while(begin != std::string::npos){
+            size_t end = command.find(' ', begin);
+            words.push_back(command.substr(begin, end == std::string::npos ? std::string::npos : end - begin));
+            begin = command.find_first_not_of(' ', end);
+        }
+        if(words.empty()){
+            return "ERROR empty command\n";
+        }
+
+        try{
+            std::string reply;
+            uint32_t logger_id;
+            spdlog::level::level_enum level;
+            if(words[0] == "help" && words.size() == 1){
+                reply = "list\n"
+                        "sinks\n"
+                        "level <logger name or id> <level>\n"
+                        "sink_level <sink> <level>\n"
+                        "flush [<logger name or id>]\n"
+                        "dump <logger name or id>\n"
+                        "reopen [<sink>]\n"
+                        "stats\n";
+            }
+            else if(words[0] == "list" && words.size() == 1){
+                for(uint32_t i = 0; i < logger_count_; i++){
+                    reply += std::to_string(i) + " " + logger_table_[i]->name() + " " + LevelName(GetLoggerLevel(i)) + "\n";
+                }
+            }
+            else if(words[0] == "sinks" && words.size() == 1){
+                std::map<std::string, std::shared_ptr<spdlog::sinks::sink>> sorted_sinks(sink_map_.begin(), sink_map_.end());
+                std::map<std::string, std::shared_ptr<spdlog::sinks::sink>>::iterator it;
+                for(it = sorted_sinks.begin(); it != sorted_sinks.end(); it++){
+                    reply += it->first + " " + LevelName(it->second->level()) + "\n";
+                }
+            }
+            else if(words[0] == "level" && words.size() == 3){
+                if(!FindAdminLogger(words[1], logger_id)) return "ERROR logger '" + words[1] + "' not found\n";
+                if(!ParseLevel(words[2], level)) return "ERROR unknown level '" + words[2] + "'\n";
+                SetLoggerLevel(logger_id, level);
+            }
+            else if(words[0] == "sink_level" && words.size() == 3){
+                std::unordered_map<std::string, std::shared_ptr<spdlog::sinks::sink>>::iterator it = sink_map_.find(words[1]);
+                if(it == sink_map_.end()) return "ERROR sink '" + words[1] + "' not found\n";
+                if(!ParseLevel(words[2], level)) return "ERROR unknown level '" + words[2] + "'\n";
+                it->second->set_level(level);
+            }
+            else if(words[0] == "flush" && words.size() <= 2){
+                if(words.size() == 2){
+                    if(!FindAdminLogger(words[1], logger_id)) return "ERROR logger '" + words[1] + "' not found\n";
+                    logger_table_[logger_id]->flush();
+                }
+                else {
+                    for(uint32_t i = 0; i < logger_count_; i++){
+                        logger_table_[i]->flush();
+                    }
+                }
+            }
+            else if(words[0] == "dump" && words.size() == 2){
+                if(!FindAdminLogger(words[1], logger_id)) return "ERROR logger '" + words[1] + "' not found\n";
+                std::shared_ptr<sinks::backtrace_sink> backtrace = FindBacktraceSink(logger_id);
+                if(backtrace == nullptr) return "ERROR logger '" + words[1] + "' has no backtrace\n";
+                backtrace->dump();
+            }
+            else if(words[0] == "reopen" && words.size() <= 2){
+                // a shared sink is reopened once
+                std::set<sinks::reopen_sink*> reopened;
+                std::unordered_map<std::string, std::shared_ptr<spdlog::sinks::sink>>::iterator it;
+                for(it = sink_map_.begin(); it != sink_map_.end(); it++){
+                    if(words.size() == 2 && it->first != words[1]){
+                        continue;
+                    }
+                    std::shared_ptr<sinks::reopen_sink> reopen = FindWrappedSink<sinks::reopen_sink>(it->second);
+                    if(reopen == nullptr || !reopened.insert(reopen.get()).second){
+                        continue;
+                    }
+                    if(!reopen->reopen()) return "ERROR reopen sink '" + it->first + "' failure\n";
+                }
+                if(words.size() == 2 && reopened.empty()) return "ERROR sink '" + words[1] + "' not reopenable\n";
+                reply = "reopened " + std::to_string(reopened.size()) + "\n";
+            }
+            else if(words[0] == "stats" && words.size() == 1){
+                reply = "pending " + std::to_string(PendingMessages()) + "\n";
+                std::shared_ptr<spdlog::details::thread_pool> tp = spdlog::details::registry::instance().get_tp();
+                if(tp != nullptr){
+                    reply += "thread_pool queue " + std::to_string(tp->queue_size()) +
+                             " overrun " + std::to_string(tp->overrun_counter()) + "\n";
+                }
+                if(worker_pool_ != nullptr){
+                    reply += "worker_pool threads " + std::to_string(worker_pool_->thread_count()) + "\n";
+                }
+                for(uint32_t i = 0; i < logger_count_; i++){
+                    if(deferred_table_[i] != nullptr){
+                        reply += "logger " + deferred_table_[i]->name() + " queue " + std::to_string(deferred_table_[i]->size()) +
+                                 " overrun " + std::to_string(deferred_table_[i]->overrun_counter()) + "\n";
+                    }
+                }
+            }
+            else {
+                return "ERROR unknown command '" + command + "', see help\n";
+            }
+            return reply + "OK\n";
+        }
+        catch(const std::exception& ex){
+            return std::string("ERROR ") + ex.what() + "\n";
+        }
+    }
+
+    /// @brief  Find a logger of the admin commands by name or id
+    bool FindAdminLogger(const std::string& logger, uint32_t& logger_id){
+        std::unordered_map<std::string, uint32_t>::iterator it = name_to_id_.find(logger);
+        if(it != name_to_id_.end()){
+            logger_id = it->second;
+            return true;
+        }
+        char* end = nullptr;
+        unsigned long id = strtoul(logger.c_str(), &end, 10);
+        if(logger.empty() || *end != '\0' || id >= logger_count_){
+            return false;
+        }
+        logger_id = static_cast<uint32_t>(id);
+        return true;
+    }
+
+    /// @brief  Get the backtrace sink of a logger, nullptr if none
+    std::shared_ptr<sinks::backtrace_sink> FindBacktraceSink(uint32_t logger_id){
+        const std::vector<std::shared_ptr<spdlog::sinks::sink>>& logger_sinks = logger_table_[logger_id]->sinks();
+        if(logger_sinks.size() != 1){
+            return nullptr;
+        }
+        return FindWrappedSink<sinks::backtrace_sink>(logger_sinks[0]);
+    }
+
+    /// @brief  Level of a logger, the level of its backtrace sink if any
+    spdlog::level::level_enum GetLoggerLevel(uint32_t logger_id){
+        std::shared_ptr<sinks::backtrace_sink> backtrace = FindBacktraceSink(logger_id);
+        return backtrace != nullptr ? backtrace->logger_level() : logger_table_[logger_id]->level();
+    }
+
+    /// @brief  Set the level of a logger, the level of its backtrace sink if any
+    ///
+    /// The level is published in the level control file, if any.
+    void SetLoggerLevel(uint32_t logger_id, spdlog::level::level_enum level){
+        std::lock_guard<std::mutex> lock(level_mutex_);
+        ApplyLoggerLevel(logger_id, level);
+        details::level_control::block* level_control = level_control_.load(std::memory_order_acquire);
+        if(level_control != nullptr){
+            applied_levels_[logger_id].store(level, std::memory_order_relaxed);
+            level_control->set_level(logger_id, level);
+        }
+    }
+
+    /// @brief  Apply to a logger the level written in the level control file
+    void ApplyControlLevel(uint32_t logger_id){
+        std::lock_guard<std::mutex> lock(level_mutex_);
+        details::level_control::block* level_control = level_control_.load(std::memory_order_acquire);
+        if(level_control == nullptr){
+            return;
+        }
+        int32_t level = level_control->level(logger_id);
+        if(level == applied_levels_[logger_id].load(std::memory_order_relaxed)){
+            return;
+        }
+        // a level out of range is not applied, and not read again until it changes
+        applied_levels_[logger_id].store(level, std::memory_order_relaxed);
+        if(level >= 0 && level < details::level_control::LEVEL_COUNT){
+            ApplyLoggerLevel(logger_id, static_cast<spdlog::level::level_enum>(level));
+        }
+    }
+
+    void ApplyLoggerLevel(uint32_t logger_id, spdlog::level::level_enum level){
+        std::shared_ptr<sinks::backtrace_sink> backtrace = FindBacktraceSink(logger_id);
+        if(backtrace != nullptr){
+            backtrace->set_logger_level(level);
+        }
+        else {
+            logger_table_[logger_id]->set_level(level);
+        }
+    }
+
+    /// @brief  Create the level control file and publish the levels of the loggers
+    ///
+    /// The file is mapped in place of the file of the previous configuration, if any.
+    bool OpenLevelControl(const std::string& path){
+        std::lock_guard<std::mutex> lock(level_mutex_);
+        if(level_control_block_ == nullptr){
+            level_control_block_.reset(new details::level_control::block());
+        }
+        details::level_control::block* level_control = level_control_block_.get();
+        std::string error;
+        if(!level_control->create(path, MAX_LOGGER_NUM, error)){
+            printf("%s::%s: Create level control file failure: %s\n", __CLASS__, __FUNCTION__, error.c_str());
+            return false;
+        }
+        for(uint32_t i = 0; i < logger_count_; i++){
+            spdlog::level::level_enum level = GetLoggerLevel(i);
+            level_control->set_slot(i, logger_table_[i]->name(), level);
+            applied_levels_[i].store(level, std::memory_order_relaxed);
+        }
+        level_control_path_ = path;
+        level_control_.store(level_control, std::memory_order_release);
+        return true;
+    }
+
+    /// @brief  Stop reading the level control file and remove it
+    ///
+    /// The file stays mapped until the next OpenLevelControl(): a thread may be reading it in GetLogger().
+    void CloseLevelControl(){
+        std::lock_guard<std::mutex> lock(level_mutex_);
+        if(level_control_.load(std::memory_order_relaxed) != nullptr){
+            level_control_.store(nullptr, std::memory_order_release);
+            ::unlink(level_control_path_.c_str());
+        }
+    }
+
+    /// @return false if name is not a level
+    static bool ParseLevel(const std::string& name, spdlog::level::level_enum& level){
+        level = spdlog::level::from_str(name);
+        return level != spdlog::level::off || name == "off";
+    }
+
+    static std::string LevelName(spdlog::level::level_enum level){
+        spdlog::string_view_t name = spdlog::level::to_string_view(level);
+        return std::string(name.data(), name.size());
+    }
+
+    /// @brief  Give up an object whose threads may be stuck, e.g. the workers of a pool on a stalled disk
+    ///
+    /// The reference is moved to a detached thread, which releases it: the last owner destroys
+    /// the object and joins its threads whenever they are done. The process may exit before.
+    template <typename T>
+    static void Abandon(std::shared_ptr<T> object){
+        if(object != nullptr){
+            std::thread([](std::shared_ptr<T> released){ released.reset(); }, std::move(object)).detach();
+        }
+    }
+
+    /// @brief  Number of messages in the async queues
+    size_t PendingMessages(){
+        size_t pending = 0;
+        for(uint32_t i = 0; i < logger_count_; i++){
+            if(deferred_table_[i] != nullptr){
+                pending += deferred_table_[i]->size();
+            }
+        }
+
+        std::shared_ptr<spdlog::details::thread_pool> tp = spdlog::details::registry::instance().get_tp();
+        if(tp != nullptr){
+            pending += tp->queue_size();
+        }
+        return pending;
+    }
+
+    /// @brief  Parse the "compress" configuration of a sink
+    ///
+    /// @param  [in]  sink_name  the sink name
+    /// @param  [in]  value      the sink configuration
+    /// @param  [out] compress   true if "compress" is configured
+    /// @param  [out] format     the compression format
+    /// @param  [out] level      the compression level
+    /// @return true if success, otherwise false
+    bool ParseCompress(const std::string& sink_name, const rapidjson::Value& value,
+                       bool& compress, details::compress_format& format, int& level){
+        compress = false;
+        format = details::compress_format::gzip;
+        level = 6;
+
+        rapidjson::Value::ConstMemberIterator it = value.FindMember("compress");
+        if(it == value.MemberEnd()){
+            return true;
+        }
+        compress = true;
+
+        rapidjson::Value::ConstMemberIterator param_it = it->value.FindMember("format");
+        if(param_it != it->value.MemberEnd()){
+            std::string format_name(param_it->value.GetString());
+            if(format_name == "gzip"){
+                format = details::compress_format::gzip;
+            }
+#ifdef SPDLOG_JSON_CONFIG_WITH_ZSTD
+            else if(format_name == "zstd"){
+                format = details::compress_format::zstd;
+                level = 3;
+            }
+#endif
+            else {
+                printf("%s::%s: compress format '%s' of sink '%s' not supported\n",
+                       __CLASS__, __FUNCTION__, format_name.c_str(), sink_name.c_str());
+                return false;
+            }
+        }
+
+        param_it = it->value.FindMember("level");
+        if(param_it != it->value.MemberEnd()){
+            level = param_it->value.GetInt();
+        }
+        return true;
+    }
+
+    /// @brief  Parse the "rate_limit" of a sink or logger configuration
+    ///
+    /// @param  [in]  name     the sink or logger name
+    /// @param  [in]  value    the sink or logger configuration
+    /// @param  [out] limiter  the rate limiter, nullptr if "rate_limit" is not configured
+    /// @return true if success, otherwise false
+    bool ParseRateLimit(const std::string& name, const rapidjson::Value& value,
+                        std::shared_ptr<details::rate_limiter>& limiter){
+        limiter.reset();
+        rapidjson::Value::ConstMemberIterator it = value.FindMember("rate_limit");
+        if(it == value.MemberEnd()){
+            return true;
+        }
+
+        double   messages_per_sec = 0;
+        double   burst = 0;
+        double   bytes_per_sec = 0;
+        uint32_t summary_interval_ms = 1000;
+        rapidjson::Value::ConstMemberIterator param_it = it->value.FindMember("messages_per_sec");
+        if(param_it != it->value.MemberEnd()) messages_per_sec = param_it->value.GetDouble();
+        param_it = it->value.FindMember("burst");
+        if(param_it != it->value.MemberEnd()) burst = param_it->value.GetDouble();
+        param_it = it->value.FindMember("bytes_per_sec");
+        if(param_it != it->value.MemberEnd()) bytes_per_sec = param_it->value.GetDouble();
+        param_it = it->value.FindMember("summary_interval_ms");
+        if(param_it != it->value.MemberEnd()) summary_interval_ms = param_it->value.GetUint();
+
+        if(messages_per_sec <= 0 && bytes_per_sec <= 0){
+            printf("%s::%s: rate_limit of '%s' needs messages_per_sec or bytes_per_sec\n",
+                   __CLASS__, __FUNCTION__, name.c_str());
+            return false;
+        }
+        limiter = std::make_shared<details::rate_limiter>(messages_per_sec, burst, bytes_per_sec,
+                                                          std::chrono::milliseconds(summary_interval_ms));
+        return true;
+    }
+
+    /// @brief  Get the compressor of the rotated files, start it if needed
+    std::shared_ptr<details::background_compressor> GetCompressor(){
+        if(compressor_ == nullptr){
+            compressor_ = std::make_shared<details::background_compressor>(compress_concurrency_);
+        }
+        return compressor_;
+    }
+
+    /// @brief  Find the sink of type T in a chain of proxy sinks
+    ///
+    /// @return nullptr if not found
+    template<typename T>
+    static std::shared_ptr<T> FindWrappedSink(std::shared_ptr<spdlog::sinks::sink> sink){
+        while(sink != nullptr){
+            std::shared_ptr<T> found = std::dynamic_pointer_cast<T>(sink);
+            if(found != nullptr){
+                return found;
+            }
+            std::shared_ptr<sinks::proxy_sink> proxy = std::dynamic_pointer_cast<sinks::proxy_sink>(sink);
+            if(proxy == nullptr){
+                break;
+            }
+            sink = proxy->wrapped_sink();
+        }
+        return nullptr;
+    }
+
+    /// @brief  Whether the sink type is a spdlog file sink writing through stdio
+    bool IsStdioFileSinkType(const std::string& sink_type){
+        return sink_type == SINK_TYPE_BASIC_FILE_SINK_ST || sink_type == SINK_TYPE_BASIC_FILE_SINK_MT ||
+               sink_type == SINK_TYPE_DAILY_FILE_SINK_ST || sink_type == SINK_TYPE_DAILY_FILE_SINK_MT ||
+               sink_type == SINK_TYPE_ROTATING_FILE_SINK_ST || sink_type == SINK_TYPE_ROTATING_FILE_SINK_MT;
+    }
+
+    /// @brief  Whether the sink type writes the records formatted with its pattern, and nothing else
+    ///
+    /// Not the color sinks (colors come from the formatting), the syslog sinks (the payload
+    /// is sent unformatted) and the binary file sinks.
+    bool IsFormatOnceSinkType(const std::string& sink_type){
+        return sink_type == SINK_TYPE_STDOUT_SINK_ST || sink_type == SINK_TYPE_STDOUT_SINK_MT ||
+               sink_type == SINK_TYPE_STDERR_SINK_ST || sink_type == SINK_TYPE_STDERR_SINK_MT ||
+               IsStdioFileSinkType(sink_type) ||
+               sink_type == SINK_TYPE_MMAP_FILE_SINK_ST || sink_type == SINK_TYPE_MMAP_FILE_SINK_MT ||
+               sink_type == SINK_TYPE_IO_URING_FILE_SINK_ST || sink_type == SINK_TYPE_IO_URING_FILE_SINK_MT ||
+               sink_type == SINK_TYPE_DIRECT_FILE_SINK_ST || sink_type == SINK_TYPE_DIRECT_FILE_SINK_MT ||
+               sink_type == SINK_TYPE_COMPRESSED_FILE_SINK_ST || sink_type == SINK_TYPE_COMPRESSED_FILE_SINK_MT ||
+               sink_type == SINK_TYPE_FLIGHT_RECORDER_SINK_ST || sink_type == SINK_TYPE_FLIGHT_RECORDER_SINK_MT ||
+               sink_type == SINK_TYPE_UNIX_SOCKET_SINK_ST || sink_type == SINK_TYPE_UNIX_SOCKET_SINK_MT ||
+               sink_type == SINK_TYPE_SHARDED_FILE_SINK;
+    }
+
+    bool IsThreadSafeSinkType(const std::string& sink_type){
+        static const std::string mt_suffix("_mt");
+        if(sink_type == SINK_TYPE_SHARDED_FILE_SINK){
+            return true;
+        }
+        return sink_type.size() >= mt_suffix.size() &&
+               sink_type.compare(sink_type.size() - mt_suffix.size(), mt_suffix.size(), mt_suffix) == 0;
+    }
+
+    bool CreateDirectory(const char* dir_path){
+        struct stat st = {0};
+        if(stat(dir_path, &st) == -1){
+            if (mkdir(dir_path, 0755) == -1) return false;
+        }
+        return true;
+    }
+
+    std::shared_ptr<spdlog::logger>
+    CreateSync(const std::string& logger_name,
+               std::vector<std::shared_ptr<spdlog::sinks::sink>>& sink_list){
+        auto new_logger = std::make_shared<spdlog::logger>(std::move(logger_name),
+                                                               begin(sink_list), end(sink_list));
+            //spdlog::details::registry::instance().register_and_init(new_logger);
+            return new_logger;
     }
 
     std::shared_ptr<spdlog::async_logger>
@@ -709,20 +2529,43 @@ private:
         return new_logger;
     }
 
+    std::shared_ptr<deferred_async_logger>
+    CreateAsyncDeferred(const std::string& logger_name,
+                        std::vector<std::shared_ptr<spdlog::sinks::sink>>& sink_list,
+                        uint32_t thread_count, uint32_t queue_size,
+                        spdlog::async_overflow_policy policy){
+        if(worker_pool_ == nullptr){
+            worker_pool_ = std::make_shared<details::worker_pool>(thread_count);
+        }
+
+        return std::make_shared<deferred_async_logger>(logger_name,
+                                                       begin(sink_list), end(sink_list),
+                                                       worker_pool_, queue_size, policy);
+    }
+
 
     std::string DEFAULT_PATTERN;
     std::shared_ptr<spdlog::sinks::sink> DEFAULT_SINK;
     std::shared_ptr<spdlog::logger> DEFAULT_LOGGER;
 
-    /// set to store all currently support sink type
-    std::set<std::string> supported_sink_type_;
+    /// map of sink type to the factory of its sinks
+    std::unordered_map<std::string, SinkFactory> sink_factories_;
+
+    /// canonical paths of the plugins loaded
+    std::set<std::string> loaded_plugins_;
 
     /// map to map logger name to logger id
     std::unordered_map<std::string, uint32_t> name_to_id_;
 
+    /// names of the loggers replaced by Shutdown(), registered in spdlog until configured again
+    std::set<std::string> released_loggers_;
+
     /// table to store all shared_ptr to created spdlog::logger. For efficient access.
     std::shared_ptr<spdlog::logger> logger_table_[MAX_LOGGER_NUM];
 
+    /// table to store the loggers queued on the worker pool, indexed by logger id
+    std::shared_ptr<deferred_async_logger> deferred_table_[MAX_LOGGER_NUM];
+
     /// total number of spdlog::logger created
     uint32_t logger_count_;
 
@@ -731,6 +2574,45 @@ private:
 
     /// map to map sink name to shared_ptr to created sinks
     std::unordered_map<std::string, std::shared_ptr<spdlog::sinks::sink>> sink_map_;
+
+    /// names of the sinks written by the async loggers, i.e. by the workers
+    std::set<std::string> async_sinks_;
+
+    /// interval of the periodic flusher in milliseconds, 0 if not configured
+    uint32_t flush_interval_ms_;
+
+    /// workers formatting and writing the records of the loggers queued on it
+    std::shared_ptr<details::worker_pool> worker_pool_;
+
+    /// thread flushing the sinks written since its last tick
+    std::unique_ptr<details::periodic_flusher> periodic_flusher_;
+
+    /// number of threads compressing the rotated files
+    uint32_t compress_concurrency_;
+
+    /// threads compressing the rotated files, shared with the sinks compressing them
+    std::shared_ptr<details::background_compressor> compressor_;
+
+    /// level control file read by GetLogger(), nullptr if not configured
+    std::atomic<details::level_control::block*> level_control_;
+
+    /// path of the level control file
+    std::string level_control_path_;
+
+    /// level of the level control file last applied to every logger, by logger id
+    std::atomic<int32_t> applied_levels_[MAX_LOGGER_NUM];
+
+    /// lock of the level changes of the loggers, by the level control file and the admin socket
+    std::mutex level_mutex_;
+
+    /// mapping of the level control files, kept until exit. Every file is mapped at the same address.
+    std::unique_ptr<details::level_control::block> level_control_block_;
+
+    /// path of the admin socket, empty if not configured
+    std::string admin_socket_path_;
+
+    /// thread serving the commands of the admin socket. Last, to be stopped first.
+    std::unique_ptr<details::admin_server> admin_server_;
 };
 
 } // namespace spdlog_json_config
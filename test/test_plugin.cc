@@ -0,0 +1,20 @@
+// Plugin of the unit test, registering the sink type "plugin_file_sink_mt"
+
+#include "spdlog/sinks/basic_file_sink.h"
+
+#include "plugin.h"
+
+
+static std::shared_ptr<spdlog::sinks::sink> CreatePluginFileSink(const std::string& sink_name,
+                                                                 const std::string& sink_type,
+                                                                 const rapidjson::Value& value){
+    rapidjson::Value::ConstMemberIterator it = value.FindMember("file_name");
+    if(it == value.MemberEnd()){
+        return nullptr;
+    }
+    return std::make_shared<spdlog::sinks::basic_file_sink_mt>(it->value.GetString(), true);
+}
+
+extern "C" bool SPDLOG_JSON_CONFIG_PLUGIN_ENTRY(spdlog_json_config::plugin_registry* registry){
+    return registry->register_sink_type("plugin_file_sink_mt", CreatePluginFileSink);
+}
@@ -2,7 +2,24 @@
 #include "catch.hpp"
 
 
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <zlib.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
 #include "spdlog_json_config.h"
+#include "details/shard_merge.h"
+#include "details/level_control.h"
+#include "spdlog/sinks/ringbuffer_sink.h"
 
 static const char* PARSER_LOGGER_NAME = "PARSER";
 static uint32_t    PARSER_LOGGER_ID;
@@ -27,9 +44,102 @@ static uint32_t    PARSER_LOGGER_ID;
 #endif
 
 
+static std::string ReadLogFile(const std::string& file_name){
+    std::ifstream file(file_name);
+    std::stringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+
+static std::string ReadGzipFile(const std::string& file_name){
+    std::string content;
+    gzFile file = gzopen(file_name.c_str(), "rb");
+    if(file == nullptr){
+        return content;
+    }
+    char buffer[4096];
+    int size;
+    while((size = gzread(file, buffer, sizeof(buffer))) > 0){
+        content.append(buffer, size);
+    }
+    gzclose(file);
+    return content;
+}
+
+
+// Create a unix socket bound to path, listening if stream
+static int BindUnixSocket(const std::string& path, int type){
+    unlink(path.c_str());
+    int fd = socket(AF_UNIX, type | SOCK_CLOEXEC, 0);
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    if(bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0 ||
+       (type == SOCK_STREAM && listen(fd, 4) != 0)){
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+
+// Read from the socket until the content contains the text, or the timeout expires
+static std::string ReadSocket(int fd, const std::string& text){
+    std::string content;
+    char buffer[4096];
+    for(int i = 0; i < 100 && content.find(text) == std::string::npos; i++){
+        ssize_t size = recv(fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+        if(size > 0){
+            content.append(buffer, size);
+        }
+        else {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+    }
+    return content;
+}
+
+
+// Read the log file until it contains the text, or the timeout expires
+static std::string WaitLogFile(const std::string& file_name, const std::string& text){
+    std::string content;
+    for(int i = 0; i < 100; i++){
+        content = ReadLogFile(file_name);
+        if(content.find(text) != std::string::npos){
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    return content;
+}
+
+
+// Send a command to the admin socket and read the reply until the server closes
+static std::string AdminCommand(const std::string& path, const std::string& command){
+    std::string reply;
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    if(connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) == 0 &&
+       send(fd, (command + "\n").data(), command.size() + 1, MSG_NOSIGNAL) == static_cast<ssize_t>(command.size() + 1)){
+        shutdown(fd, SHUT_WR);
+        char buffer[4096];
+        ssize_t size;
+        while((size = recv(fd, buffer, sizeof(buffer), 0)) > 0){
+            reply.append(buffer, size);
+        }
+    }
+    close(fd);
+    return reply;
+}
+
 TEST_CASE("Test MACRO", "[MACRO_PARSER]"){
 
-    spdlog::shutdown();
+    spdlog_json_config::SpdlogJsonConfig::GetInstance()->Shutdown(std::chrono::milliseconds(1000));
     REQUIRE(spdlog_json_config::SpdlogJsonConfig::GetInstance()->Initialize("./parser_logger_config.json") == true);
 
     REQUIRE(spdlog_json_config::SpdlogJsonConfig::GetInstance()->GetLoggerId(PARSER_LOGGER_NAME, PARSER_LOGGER_ID) == true);
@@ -82,4 +192,1229 @@ TEST_CASE("Test MACRO", "[MACRO_PARSER]"){
 }
 
 
+TEST_CASE("Test flush_on and periodic flush", "[FLUSH]"){
+
+    spdlog_json_config::SpdlogJsonConfig::GetInstance()->Shutdown(std::chrono::milliseconds(1000));
+    REQUIRE(spdlog_json_config::SpdlogJsonConfig::GetInstance()->Initialize("./flush_logger_config.json") == true);
+
+    std::shared_ptr<spdlog::logger> logger = GET_LOGGER("FLUSH");
+    REQUIRE(logger != nullptr);
+
+    // flush_on: a warning is flushed immediately
+    logger->warn("flush on warn");
+    REQUIRE(ReadLogFile("./logs/flush.log").find("flush on warn") != std::string::npos);
+
+    // flush_interval_ms: an info message is flushed by the periodic flusher
+    logger->info("flush by flusher");
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    REQUIRE(ReadLogFile("./logs/flush.log").find("flush by flusher") != std::string::npos);
+}
+
+
+TEST_CASE("Test async_deferred logger", "[DEFERRED]"){
+
+    spdlog_json_config::SpdlogJsonConfig::GetInstance()->Shutdown(std::chrono::milliseconds(1000));
+    REQUIRE(spdlog_json_config::SpdlogJsonConfig::GetInstance()->Initialize("./deferred_logger_config.json") == true);
+
+    std::shared_ptr<spdlog_json_config::deferred_async_logger> logger =
+        spdlog_json_config::SpdlogJsonConfig::GetInstance()->GetDeferredLogger("DEFERRED");
+    REQUIRE(logger != nullptr);
+    REQUIRE(spdlog_json_config::SpdlogJsonConfig::GetInstance()->GetDeferredLogger("PARSER") == nullptr);
+
+    logger->info("int {} double {:.2f} string {} c-string {}", 42, 3.14159, std::string("abc"), "xyz");
+    logger->debug("too large for a slot {}", std::string(1000, 'x'));
+    GET_LOGGER("DEFERRED")->info("formatted by the caller {}", 1);
+    {
+        // refers to the vector: formatted by the caller, before the vector is gone
+        std::vector<int> values = {1, 2, 3};
+        REQUIRE(spdlog_json_config::details::deferred_args<decltype(fmt::join(values, ","))>::deferrable == false);
+        logger->info("joined {}", fmt::join(values, ","));
+        values.assign(values.size(), 0);
+    }
+    {
+        // released before the worker formats the record: formatted by the caller
+        std::string runtime_format("runtime {}");
+        logger->info(fmt::runtime(runtime_format), 42);
+        runtime_format.assign(runtime_format.size(), 'x');
+    }
+    REQUIRE(spdlog_json_config::details::deferred_args<int, double, const char*, void*>::deferrable == true);
+    REQUIRE(spdlog_json_config::details::deferred_args<std::reference_wrapper<int>>::deferrable == false);
+    for(int i = 0; i < 3000; i++){
+        logger->warn("ordered {}", i);
+    }
+    logger->flush();
+
+    std::string content = WaitLogFile("./logs/deferred.log", "ordered 2999");
+    REQUIRE(content.find("int 42 double 3.14 string abc c-string xyz") != std::string::npos);
+    REQUIRE(content.find("too large for a slot " + std::string(1000, 'x')) != std::string::npos);
+    REQUIRE(content.find("formatted by the caller 1") < content.find("ordered 0"));
+    REQUIRE(content.find("joined 1,2,3") != std::string::npos);
+    REQUIRE(content.find("runtime 42") != std::string::npos);
+
+    size_t last_pos = 0;
+    for(int i = 0; i < 3000; i++){
+        size_t pos = content.find("ordered " + std::to_string(i) + "\n");
+        REQUIRE(pos != std::string::npos);
+        REQUIRE(pos >= last_pos);
+        last_pos = pos;
+    }
+}
+
+
+TEST_CASE("Test elastic thread pool", "[ELASTIC]"){
+
+    spdlog_json_config::SpdlogJsonConfig::GetInstance()->Shutdown(std::chrono::milliseconds(1000));
+    spdlog_json_config::SpdlogJsonConfig* instance = spdlog_json_config::SpdlogJsonConfig::GetInstance();
+    REQUIRE(instance->Initialize("./elastic_logger_config.json") == true);
+
+    std::shared_ptr<spdlog_json_config::details::worker_pool> pool = instance->GetWorkerPool();
+    REQUIRE(pool != nullptr);
+    REQUIRE(pool->thread_count() == 1);
+
+    const int MESSAGE_NUM = 20000;
+    const char* logger_names[] = {"ELASTIC_A", "ELASTIC_B", "ELASTIC_C"};
+    std::vector<std::thread> producers;
+    for(const char* logger_name : logger_names){
+        producers.emplace_back([instance, logger_name, MESSAGE_NUM](){
+            std::shared_ptr<spdlog::logger> logger = instance->GetLogger(logger_name);
+            for(int i = 0; i < MESSAGE_NUM; i++){
+                logger->info("message {}", i);
+            }
+            logger->flush();
+        });
+    }
+
+    size_t max_thread_count = 0;
+    for(int i = 0; i < 200 && max_thread_count < pool->max_threads(); i++){
+        max_thread_count = std::max(max_thread_count, pool->thread_count());
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    for(auto& producer : producers){
+        producer.join();
+    }
+
+    // The blocking loggers keep every message in order
+    const char* file_names[] = {"./logs/elastic_a.log", "./logs/elastic_b.log"};
+    for(const char* file_name : file_names){
+        std::string content = WaitLogFile(file_name, "message " + std::to_string(MESSAGE_NUM - 1) + "\n");
+        size_t pos = content.find("message 0\n");
+        for(int i = 0; i < MESSAGE_NUM; i++){
+            std::string line = "message " + std::to_string(i) + "\n";
+            REQUIRE(content.compare(pos, line.size(), line) == 0);
+            pos += line.size();
+        }
+    }
+
+    // Extra workers were started during the burst and retire when idle
+    REQUIRE(max_thread_count > 1);
+    for(int i = 0; i < 100 && pool->thread_count() > 1; i++){
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    REQUIRE(pool->thread_count() == 1);
+}
+
+
+TEST_CASE("Test thread pool affinity", "[AFFINITY]"){
+
+    spdlog_json_config::SpdlogJsonConfig::GetInstance()->Shutdown(std::chrono::milliseconds(1000));
+    spdlog_json_config::SpdlogJsonConfig* instance = spdlog_json_config::SpdlogJsonConfig::GetInstance();
+    REQUIRE(instance->Initialize("./affinity_logger_config.json") == true);
+    REQUIRE(instance->GetWorkerPool()->partitioned());
+
+    // loggers sharing sinks are pinned to the same worker
+    REQUIRE(instance->GetDeferredLogger("AFFINITY_A")->partition() ==
+            instance->GetDeferredLogger("AFFINITY_B")->partition());
+    REQUIRE(instance->GetDeferredLogger("AFFINITY_C")->partition() ==
+            instance->GetDeferredLogger("AFFINITY_D")->partition());
+    // sinks writing the same file are the same sink
+    REQUIRE(instance->GetDeferredLogger("AFFINITY_A")->partition() ==
+            instance->GetDeferredLogger("AFFINITY_E")->partition());
+
+    const int MESSAGE_NUM = 10000;
+    const char* logger_names[] = {"AFFINITY_A", "AFFINITY_B"};
+    std::vector<std::thread> producers;
+    for(const char* logger_name : logger_names){
+        producers.emplace_back([instance, logger_name, MESSAGE_NUM](){
+            std::shared_ptr<spdlog::logger> logger = instance->GetLogger(logger_name);
+            for(int i = 0; i < MESSAGE_NUM; i++){
+                logger->info("message {}", i);
+            }
+            logger->flush();
+        });
+    }
+    for(auto& producer : producers){
+        producer.join();
+    }
+
+    // messages of each logger keep their order in the shared file
+    std::string last_a = "[AFFINITY_A] message " + std::to_string(MESSAGE_NUM - 1) + "\n";
+    std::string last_b = "[AFFINITY_B] message " + std::to_string(MESSAGE_NUM - 1) + "\n";
+    std::string content = WaitLogFile("./logs/affinity_ab.log", last_a);
+    content = WaitLogFile("./logs/affinity_ab.log", last_b);
+    for(const char* logger_name : logger_names){
+        size_t last_pos = 0;
+        for(int i = 0; i < MESSAGE_NUM; i++){
+            std::string line = std::string("[") + logger_name + "] message " + std::to_string(i) + "\n";
+            size_t pos = content.find(line, last_pos);
+            REQUIRE(pos != std::string::npos);
+            last_pos = pos + line.size();
+        }
+    }
+}
+
+
+/// Sink blocking in sink_it_() until released, like a sink on a stalled disk
+class stalled_sink : public spdlog::sinks::base_sink<std::mutex> {
+public:
+    static std::atomic<bool> entered;
+    static std::atomic<bool> released;
+
+protected:
+    void sink_it_(const spdlog::details::log_msg&) override {
+        entered = true;
+        while(!released){
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    void flush_() override {}
+};
+
+std::atomic<bool> stalled_sink::entered(false);
+std::atomic<bool> stalled_sink::released(false);
+
+
+TEST_CASE("Test drain and shutdown", "[SHUTDOWN]"){
+
+    spdlog_json_config::SpdlogJsonConfig* instance = spdlog_json_config::SpdlogJsonConfig::GetInstance();
+    instance->Shutdown(std::chrono::milliseconds(1000));
+    REQUIRE(instance->Initialize("./shutdown_logger_config.json") == true);
+
+    const int MESSAGE_NUM = 5000;
+    std::shared_ptr<spdlog::logger> async_logger = instance->GetLogger("SHUTDOWN_ASYNC");
+    std::shared_ptr<spdlog_json_config::deferred_async_logger> deferred_logger =
+        instance->GetDeferredLogger("SHUTDOWN_DEFERRED");
+    for(int i = 0; i < MESSAGE_NUM; i++){
+        async_logger->info("async {}", i);
+        deferred_logger->info("deferred {}", i);
+    }
+
+    // every queued message is written before Shutdown returns
+    REQUIRE(instance->Shutdown(std::chrono::milliseconds(5000)) == 0);
+    std::string content = ReadLogFile("./logs/shutdown.log");
+    REQUIRE(content.find("async " + std::to_string(MESSAGE_NUM - 1) + "\n") != std::string::npos);
+    REQUIRE(content.find("deferred " + std::to_string(MESSAGE_NUM - 1) + "\n") != std::string::npos);
+
+    // the loggers are still usable but drop their messages
+    async_logger->info("after shutdown");
+    deferred_logger->info("after shutdown");
+    instance->GetLogger("SHUTDOWN_ASYNC")->info("after shutdown");
+    deferred_logger->flush();
+    REQUIRE(ReadLogFile("./logs/shutdown.log").find("after shutdown") == std::string::npos);
+
+    // the ids are reclaimed, and given again by the next configuration
+    uint32_t logger_id = 0;
+    REQUIRE(instance->GetLoggerId("SHUTDOWN_DEFERRED", logger_id) == false);
+    REQUIRE(instance->GetDeferredLogger("SHUTDOWN_DEFERRED") == nullptr);
+    REQUIRE(instance->Initialize("./shutdown_logger_config.json") == true);
+    REQUIRE(instance->GetLoggerId("SHUTDOWN_ASYNC", logger_id) == true);
+    REQUIRE(logger_id == 1);
+    REQUIRE(instance->GetLogger(logger_id) == instance->GetLogger("SHUTDOWN_ASYNC"));
+    REQUIRE(instance->GetLogger(logger_id) != async_logger);
+
+    // a logger configured again keeps its id
+    REQUIRE(instance->Initialize("./shutdown_logger_config.json") == true);
+    REQUIRE(instance->GetLoggerId("SHUTDOWN_ASYNC", logger_id) == true);
+    REQUIRE(logger_id == 1);
+    instance->Shutdown(std::chrono::milliseconds(1000));
+
+    // past MAX_LOGGER_NUM loggers, the configuration fails
+    std::string loggers;
+    for(uint32_t i = 0; i < spdlog_json_config::SpdlogJsonConfig::MAX_LOGGER_NUM; i++){
+        loggers += std::string(i > 0 ? "," : "") + "\"ID_LIMIT_" + std::to_string(i) + "\": {\"sync_type\": \"sync\"}";
+    }
+    FILE* limit_file = fopen("./logs/id_limit_config.json", "w");
+    REQUIRE(limit_file != nullptr);
+    fputs(("{\"LOGGERS\": {" + loggers + "}}").c_str(), limit_file);
+    fclose(limit_file);
+    REQUIRE(instance->Initialize("./logs/id_limit_config.json") == false);
+    instance->Shutdown(std::chrono::milliseconds(1000));
+
+    // a worker stuck on a sink with a full queue neither blocks Shutdown past the deadline,
+    // nor the flush of the sinks of the sync loggers
+    REQUIRE(instance->RegisterSinkType("stalled_sink_mt",
+        [](const std::string&, const std::string&, const rapidjson::Value&){
+            return std::static_pointer_cast<spdlog::sinks::sink>(std::make_shared<stalled_sink>());
+        }) == true);
+    FILE* file = fopen("./logs/shutdown_stalled_config.json", "w");
+    REQUIRE(file != nullptr);
+    fputs("{\"SINKS\": {\"stalled\": {\"type\": \"stalled_sink_mt\"},"
+          "\"sync_file\": {\"type\": \"basic_file_sink_mt\", \"file_name\": \"./logs/shutdown_sync.log\", \"truncate\": true}},"
+          "\"LOGGERS\": {\"SHUTDOWN_STALLED\": {\"sinks\": [\"stalled\"], \"sync_type\": \"async\"},"
+          "\"SHUTDOWN_SYNC\": {\"sinks\": [\"sync_file\"], \"sync_type\": \"sync\"}},"
+          "\"THREAD_POOL\": {\"thread_count\": 1, \"queue_size\": 8}}", file);
+    fclose(file);
+    REQUIRE(instance->Initialize("./logs/shutdown_stalled_config.json") == true);
+
+    std::shared_ptr<spdlog::logger> stalled_logger = instance->GetLogger("SHUTDOWN_STALLED");
+    while(!stalled_sink::entered){
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));   // stuck on "Logger started"
+    }
+    for(int i = 0; i < 8; i++){
+        stalled_logger->info("stalled {}", i);
+    }
+    instance->GetLogger("SHUTDOWN_SYNC")->info("sync message");
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    REQUIRE(instance->Shutdown(std::chrono::milliseconds(100)) > 0);
+    REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::seconds(2));
+    REQUIRE(ReadLogFile("./logs/shutdown_sync.log").find("sync message") != std::string::npos);
+    stalled_sink::released = true;
+}
+
+
+TEST_CASE("Test mmap file sink", "[MMAP]"){
+
+    spdlog_json_config::SpdlogJsonConfig* instance = spdlog_json_config::SpdlogJsonConfig::GetInstance();
+    instance->Shutdown(std::chrono::milliseconds(1000));
+    REQUIRE(instance->Initialize("./mmap_logger_config.json") == true);
+
+    // the 4KB window is extended many times
+    const int MESSAGE_NUM = 1000;
+    std::shared_ptr<spdlog::logger> logger = instance->GetLogger("MMAP");
+    for(int i = 0; i < MESSAGE_NUM; i++){
+        logger->info("message {}", i);
+    }
+    logger->flush();
+    std::string content = ReadLogFile("./logs/mmap.log");
+    REQUIRE(content.find("message " + std::to_string(MESSAGE_NUM - 1) + "\n") != std::string::npos);
+
+    // the preallocated tail is truncated when the sink is closed
+    logger.reset();
+    instance->Shutdown(std::chrono::milliseconds(1000));
+    content = ReadLogFile("./logs/mmap.log");
+    std::string last_line = "message " + std::to_string(MESSAGE_NUM - 1) + "\n";
+    REQUIRE(content.find('\0') == std::string::npos);
+    REQUIRE(content.size() == content.rfind(last_line) + last_line.size());
+}
+
+
+TEST_CASE("Test io_uring file sink", "[IO_URING]"){
+
+    spdlog_json_config::SpdlogJsonConfig* instance = spdlog_json_config::SpdlogJsonConfig::GetInstance();
+    instance->Shutdown(std::chrono::milliseconds(1000));
+    REQUIRE(instance->Initialize("./io_uring_logger_config.json") == true);
+
+    // more records than the 4 buffers of 4KB can hold, and a record larger than a buffer
+    const int MESSAGE_NUM = 2000;
+    std::shared_ptr<spdlog::logger> logger = instance->GetLogger("IO_URING");
+    for(int i = 0; i < MESSAGE_NUM; i++){
+        logger->info("message {}", i);
+        if(i == MESSAGE_NUM / 2){
+            logger->info("large {}", std::string(10000, 'x'));
+        }
+    }
+    logger->flush();
+
+    std::string content = ReadLogFile("./logs/io_uring.log");
+    size_t last_pos = 0;
+    for(int i = 0; i < MESSAGE_NUM; i++){
+        size_t pos = content.find("message " + std::to_string(i) + "\n", last_pos);
+        REQUIRE(pos != std::string::npos);
+        last_pos = pos;
+    }
+    REQUIRE(content.find("large " + std::string(10000, 'x') + "\n") != std::string::npos);
+    REQUIRE(content.find('\0') == std::string::npos);
+}
+
+
+TEST_CASE("Test O_DIRECT file sink and fadvise", "[DIRECT]"){
+
+    spdlog_json_config::SpdlogJsonConfig* instance = spdlog_json_config::SpdlogJsonConfig::GetInstance();
+    instance->Shutdown(std::chrono::milliseconds(1000));
+    REQUIRE(instance->Initialize("./direct_logger_config.json") == true);
+
+    // the tail block is padded on flush, then written again with the next records
+    const int MESSAGE_NUM = 1000;
+    std::shared_ptr<spdlog::logger> logger = instance->GetLogger("DIRECT");
+    for(int round = 0; round < 2; round++){
+        for(int i = 0; i < MESSAGE_NUM; i++){
+            logger->info("round {} message {}", round, i);
+        }
+        logger->flush();
+
+        const char* file_names[] = {"./logs/direct.log", "./logs/fadvise.log"};
+        for(const char* file_name : file_names){
+            std::string content = ReadLogFile(file_name);
+            std::string last_line = "round " + std::to_string(round) + " message " + std::to_string(MESSAGE_NUM - 1) + "\n";
+            REQUIRE(content.find('\0') == std::string::npos);
+            REQUIRE(content.size() == content.rfind(last_line) + last_line.size());
+
+            size_t last_pos = 0;
+            for(int i = 0; i < MESSAGE_NUM; i++){
+                size_t pos = content.find("round 0 message " + std::to_string(i) + "\n", last_pos);
+                REQUIRE(pos != std::string::npos);
+                last_pos = pos;
+            }
+        }
+    }
+}
+
+
+TEST_CASE("Test file sink write buffer", "[BUFFERED]"){
+
+    spdlog_json_config::SpdlogJsonConfig* instance = spdlog_json_config::SpdlogJsonConfig::GetInstance();
+    instance->Shutdown(std::chrono::milliseconds(1000));
+    REQUIRE(instance->Initialize("./buffered_logger_config.json") == true);
+
+    // the buffer is written after max_buffer_delay_ms, or on flush_on
+    std::shared_ptr<spdlog::logger> logger = instance->GetLogger("BUFFERED");
+    logger->info("buffered message");
+    REQUIRE(ReadLogFile("./logs/buffered.log").find("buffered message") == std::string::npos);
+    REQUIRE(WaitLogFile("./logs/buffered.log", "buffered message").find("buffered message") != std::string::npos);
+
+    logger->info("info before error");
+    logger->error("flush on error");
+    std::string content = ReadLogFile("./logs/buffered.log");
+    REQUIRE(content.find("info before error") < content.find("flush on error"));
+
+    // the files rotate between buffers: no record is split, no file exceeds max_size
+    std::shared_ptr<spdlog::logger> rotate_logger = instance->GetLogger("BUFFERED_ROTATE");
+    for(int i = 0; i < 100; i++){
+        rotate_logger->info("rotated message {}", i);
+    }
+    rotate_logger->flush();
+    const char* file_names[] = {"./logs/buffered_rotate.log", "./logs/buffered_rotate.1.log"};
+    for(const char* file_name : file_names){
+        content = ReadLogFile(file_name);
+        REQUIRE(content.size() > 0);
+        REQUIRE(content.size() <= 4096);
+        REQUIRE(content.back() == '\n');
+        REQUIRE(content.compare(0, 1, "[") == 0);
+    }
+    REQUIRE(ReadLogFile(file_names[0]).find("rotated message 99\n") != std::string::npos);
+}
+
+
+TEST_CASE("Test compression of rotated files", "[COMPRESS]"){
+
+    spdlog_json_config::SpdlogJsonConfig* instance = spdlog_json_config::SpdlogJsonConfig::GetInstance();
+    instance->Shutdown(std::chrono::milliseconds(1000));
+    for(int i = 1; i <= 4; i++){
+        std::remove(("./logs/compress." + std::to_string(i) + ".log.gz").c_str());
+    }
+    REQUIRE(instance->Initialize("./compress_logger_config.json") == true);
+
+    std::shared_ptr<spdlog::logger> logger = instance->GetLogger("COMPRESS");
+    for(int i = 0; i < 300; i++){
+        logger->info("rotated message {}", i);
+    }
+    logger->flush();
+
+    // each compressed file ends with the record before the first one of the newer file
+    const char* file_names[] = {"./logs/compress.log", "./logs/compress.1.log.gz",
+                                "./logs/compress.2.log.gz", "./logs/compress.3.log.gz"};
+    bool ordered = false;
+    for(int retry = 0; retry < 100 && !ordered; retry++){
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        ordered = true;
+        std::string newer = ReadLogFile(file_names[0]);
+        for(int i = 1; i < 4 && ordered; i++){
+            std::string older = ReadGzipFile(file_names[i]);
+            size_t newer_first = newer.find("rotated message ");
+            size_t older_last = older.rfind("rotated message ");
+            if(newer_first == std::string::npos || older_last == std::string::npos){
+                ordered = false;
+                break;
+            }
+            int first = std::stoi(newer.substr(newer_first + 16));
+            int last = std::stoi(older.substr(older_last + 16));
+            ordered = (last == first - 1);
+            newer = older;
+        }
+    }
+    REQUIRE(ordered);
+    REQUIRE(ReadLogFile("./logs/compress.1.log").empty());
+    REQUIRE(ReadGzipFile("./logs/compress.4.log.gz").empty());
+
+    // the rotated files left before their compression are compressed on the next start,
+    // oldest first, as the newest archives
+    instance->Shutdown(std::chrono::milliseconds(1000));
+    for(int i = 1; i <= 3; i++){
+        std::remove(("./logs/leftover." + std::to_string(i) + ".log.gz").c_str());
+    }
+    std::ofstream("./logs/leftover.1.log.7") << "older leftover\n";
+    std::ofstream("./logs/leftover.1.log.12") << "newer leftover\n";
+    REQUIRE(instance->Initialize("./compress_leftover_logger_config.json") == true);
+    std::string archive;
+    for(int retry = 0; retry < 100 && archive != "newer leftover\n"; retry++){
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        archive = ReadGzipFile("./logs/leftover.1.log.gz");
+    }
+    REQUIRE(archive == "newer leftover\n");
+    REQUIRE(ReadGzipFile("./logs/leftover.2.log.gz") == "older leftover\n");
+    REQUIRE(access("./logs/leftover.1.log.7", F_OK) != 0);
+    REQUIRE(access("./logs/leftover.1.log.12", F_OK) != 0);
+}
+
+
+TEST_CASE("Test streaming compressed file sink", "[STREAMING_COMPRESS]"){
+
+    spdlog_json_config::SpdlogJsonConfig* instance = spdlog_json_config::SpdlogJsonConfig::GetInstance();
+    instance->Shutdown(std::chrono::milliseconds(1000));
+    REQUIRE(instance->Initialize("./streaming_compress_logger_config.json") == true);
+
+    // every full frame is readable before the flush
+    const int MESSAGE_NUM = 2000;
+    std::shared_ptr<spdlog::logger> logger = instance->GetLogger("STREAMING_COMPRESS");
+    for(int i = 0; i < MESSAGE_NUM; i++){
+        logger->info("compressed message {}", i);
+    }
+    std::string content;
+    for(int retry = 0; retry < 100; retry++){
+        content = ReadGzipFile("./logs/streaming.log.gz");
+        if(content.find("compressed message 1000\n") != std::string::npos) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    REQUIRE(content.find("compressed message 1000\n") != std::string::npos);
+    REQUIRE(content.back() == '\n');
+
+    // the flush of the async logger is queued after the records
+    logger->flush();
+    const std::string last_line = "compressed message " + std::to_string(MESSAGE_NUM - 1) + "\n";
+    for(int retry = 0; retry < 100; retry++){
+        content = ReadGzipFile("./logs/streaming.log.gz");
+        if(content.find(last_line) != std::string::npos) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    size_t last_pos = 0;
+    for(int i = 0; i < MESSAGE_NUM; i++){
+        size_t pos = content.find("compressed message " + std::to_string(i) + "\n", last_pos);
+        REQUIRE(pos != std::string::npos);
+        last_pos = pos;
+    }
+
+    // a file cut in the last frame, as after a crash, is readable up to the previous frame
+    std::string compressed = ReadLogFile("./logs/streaming.log.gz");
+    std::ofstream cut("./logs/streaming_cut.log.gz", std::ios::binary | std::ios::trunc);
+    cut.write(compressed.data(), compressed.size() - 10);
+    cut.close();
+    std::string partial = ReadGzipFile("./logs/streaming_cut.log.gz");
+    REQUIRE(partial.size() > 0);
+    REQUIRE(partial.size() < content.size());
+    REQUIRE(content.compare(0, partial.size(), partial) == 0);
+}
+
+
+TEST_CASE("Test binary file sink and decoder", "[BINARY]"){
+
+    spdlog_json_config::SpdlogJsonConfig* instance = spdlog_json_config::SpdlogJsonConfig::GetInstance();
+    instance->Shutdown(std::chrono::milliseconds(1000));
+    REQUIRE(instance->Initialize("./binary_logger_config.json") == true);
+
+    const int MESSAGE_NUM = 100;
+    std::shared_ptr<spdlog::logger> logger_a = instance->GetLogger("BINARY_A");
+    std::shared_ptr<spdlog::logger> logger_b = instance->GetLogger("BINARY_B");
+    for(int i = 0; i < MESSAGE_NUM; i++){
+        logger_a->info("binary message {}", i);
+        logger_b->warn("binary message {}", i);
+    }
+    logger_a->flush();
 
+    // the records are rendered afterwards with any pattern
+    FILE* file = fopen("./logs/binary.log", "rb");
+    REQUIRE(file != nullptr);
+    spdlog_json_config::details::binary_record_reader reader(file);
+    REQUIRE(reader.read_header());
+
+    spdlog::pattern_formatter formatter("%n|%l|%t|%v", spdlog::pattern_time_type::local, "\n");
+    spdlog::details::log_msg msg;
+    spdlog::memory_buf_t formatted;
+    std::string thread_id = std::to_string(spdlog::details::os::thread_id());
+    // skip the "Logger started" records
+    std::string payload;
+    while(payload.find("binary message") == std::string::npos){
+        REQUIRE(reader.next(msg));
+        payload.assign(msg.payload.data(), msg.payload.size());
+    }
+    for(int i = 0; i < MESSAGE_NUM; i++){
+        if(i > 0) REQUIRE(reader.next(msg));
+        formatted.clear();
+        formatter.format(msg, formatted);
+        REQUIRE(std::string(formatted.data(), formatted.size()) ==
+                "BINARY_A|info|" + thread_id + "|binary message " + std::to_string(i) + "\n");
+        REQUIRE(reader.next(msg));
+        formatted.clear();
+        formatter.format(msg, formatted);
+        REQUIRE(std::string(formatted.data(), formatted.size()) ==
+                "BINARY_B|warning|" + thread_id + "|binary message " + std::to_string(i) + "\n");
+        REQUIRE(std::chrono::system_clock::now() - msg.time < std::chrono::seconds(60));
+    }
+    REQUIRE(!reader.next(msg));
+    fclose(file);
+}
+
+
+TEST_CASE("Test flight recorder sink", "[FLIGHT_RECORDER]"){
+
+    spdlog_json_config::SpdlogJsonConfig* instance = spdlog_json_config::SpdlogJsonConfig::GetInstance();
+    instance->Shutdown(std::chrono::milliseconds(1000));
+    REQUIRE(instance->Initialize("./flight_recorder_logger_config.json") == true);
+
+    // the ring keeps the last records, in order
+    const int MESSAGE_NUM = 2000;
+    std::shared_ptr<spdlog::logger> logger = instance->GetLogger("FLIGHT_RECORDER");
+    for(int i = 0; i < MESSAGE_NUM; i++){
+        logger->debug("recorded message {}", i);
+    }
+
+    std::vector<spdlog_json_config::details::flight_recorder::record> records;
+    std::string error;
+    REQUIRE(spdlog_json_config::details::flight_recorder::read("./logs/flight_recorder.ring", 0, records, error));
+    REQUIRE(records.size() > 100);
+    REQUIRE(records.size() < MESSAGE_NUM);
+    for(size_t i = 0; i < records.size(); i++){
+        int message = MESSAGE_NUM - static_cast<int>(records.size()) + static_cast<int>(i);
+        REQUIRE(records[i].text.find("recorded message " + std::to_string(message) + "\n") != std::string::npos);
+        REQUIRE(records[i].level == spdlog::level::debug);
+    }
+
+    // max_bytes keeps the newest records
+    std::vector<spdlog_json_config::details::flight_recorder::record> newest;
+    REQUIRE(spdlog_json_config::details::flight_recorder::read("./logs/flight_recorder.ring", 4096, newest, error));
+    REQUIRE(newest.size() > 0);
+    REQUIRE(newest.size() < records.size());
+    REQUIRE(newest.back().seq == records.back().seq);
+
+    // the records of a killed process are recovered
+    instance->Shutdown(std::chrono::milliseconds(1000));
+    pid_t pid = fork();
+    if(pid == 0){
+        spdlog::logger child("CHILD", std::make_shared<spdlog_json_config::sinks::flight_recorder_sink_st>(
+                                          "./logs/flight_recorder.ring", 65536, false));
+        for(int i = 0; i < 100; i++){
+            child.info("killed message {}", i);
+        }
+        kill(getpid(), SIGKILL);
+    }
+    int status;
+    REQUIRE(waitpid(pid, &status, 0) == pid);
+    REQUIRE(WIFSIGNALED(status));
+    REQUIRE(spdlog_json_config::details::flight_recorder::read("./logs/flight_recorder.ring", 0, records, error));
+    REQUIRE(records.back().text.find("killed message 99\n") != std::string::npos);
+    REQUIRE(records.back().seq == newest.back().seq + 100);
+
+    // a corrupted record ends the recovered records
+    {
+        std::fstream file("./logs/flight_recorder.ring", std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(spdlog_json_config::details::flight_recorder::HEADER_SIZE + 65536 / 2);
+        file.write("corrupted", 9);
+    }
+    std::vector<spdlog_json_config::details::flight_recorder::record> after_corruption;
+    REQUIRE(spdlog_json_config::details::flight_recorder::read("./logs/flight_recorder.ring", 0, after_corruption, error));
+    REQUIRE(after_corruption.size() < records.size());
+    REQUIRE(after_corruption.back().seq == records.back().seq);
+}
+
+
+TEST_CASE("Test backtrace dumped on error", "[BACKTRACE]"){
+
+    spdlog_json_config::SpdlogJsonConfig* instance = spdlog_json_config::SpdlogJsonConfig::GetInstance();
+    instance->Shutdown(std::chrono::milliseconds(1000));
+    REQUIRE(instance->Initialize("./backtrace_logger_config.json") == true);
+
+    // the debug records are kept, not written
+    std::shared_ptr<spdlog::logger> logger = instance->GetLogger("BACKTRACE");
+    for(int i = 0; i < 10; i++){
+        logger->debug("debug message {}", i);
+    }
+    logger->warn("warning message");
+    std::string content = ReadLogFile("./logs/backtrace.log");
+    REQUIRE(content.find("warning message") != std::string::npos);
+    REQUIRE(content.find("debug message") == std::string::npos);
+
+    // the last 4 debug records are written before the error
+    logger->error("error message");
+    content = ReadLogFile("./logs/backtrace.log");
+    REQUIRE(content.find("debug message 5\n") == std::string::npos);
+    size_t last_pos = content.find("warning message");
+    for(int i = 6; i < 10; i++){
+        size_t pos = content.find("debug message " + std::to_string(i) + "\n");
+        REQUIRE(pos != std::string::npos);
+        REQUIRE(pos > last_pos);
+        last_pos = pos;
+    }
+    REQUIRE(content.find("error message") > last_pos);
+
+    // the backtrace is written once
+    logger->error("second error message");
+    content = ReadLogFile("./logs/backtrace.log");
+    REQUIRE(content.rfind("debug message 9\n") < content.find("second error message"));
+    REQUIRE(content.find("debug message 9\n") == content.rfind("debug message 9\n"));
+}
+
+
+TEST_CASE("Test unix socket sink", "[UNIX_SOCKET]"){
+
+    spdlog_json_config::SpdlogJsonConfig* instance = spdlog_json_config::SpdlogJsonConfig::GetInstance();
+    instance->Shutdown(std::chrono::milliseconds(1000));
+    mkdir("./logs", 0755);
+    int stream_server = BindUnixSocket("./logs/agent_stream.sock", SOCK_STREAM);
+    int dgram_server = BindUnixSocket("./logs/agent_dgram.sock", SOCK_DGRAM);
+    REQUIRE(stream_server >= 0);
+    REQUIRE(dgram_server >= 0);
+    REQUIRE(instance->Initialize("./unix_socket_logger_config.json") == true);
+
+    // the records are sent by batches, and on flush
+    const int MESSAGE_NUM = 100;
+    std::shared_ptr<spdlog::logger> logger = instance->GetLogger("UNIX_SOCKET");
+    for(int i = 0; i < MESSAGE_NUM; i++){
+        logger->info("socket message {}", i);
+    }
+    logger->flush();
+
+    int stream_client = accept(stream_server, nullptr, nullptr);
+    REQUIRE(stream_client >= 0);
+    std::string content = ReadSocket(stream_client, "socket message 99\n");
+    size_t last_pos = 0;
+    for(int i = 0; i < MESSAGE_NUM; i++){
+        size_t pos = content.find("socket message " + std::to_string(i) + "\n", last_pos);
+        REQUIRE(pos != std::string::npos);
+        last_pos = pos;
+    }
+
+    // one datagram per record, the records left while the socket queue is full are sent on the next flush
+    std::vector<std::string> datagrams;
+    char buffer[4096];
+    for(int retry = 0; retry < 100 && datagrams.size() < MESSAGE_NUM + 1; retry++){
+        ssize_t size;
+        while((size = recv(dgram_server, buffer, sizeof(buffer), MSG_DONTWAIT)) > 0){
+            datagrams.push_back(std::string(buffer, size));
+        }
+        logger->flush();
+    }
+    REQUIRE(datagrams.size() == MESSAGE_NUM + 1);
+    REQUIRE(datagrams[0] == "Logger started\n");
+    for(int i = 0; i < MESSAGE_NUM; i++){
+        REQUIRE(datagrams[i + 1] == "socket message " + std::to_string(i) + "\n");
+    }
+    instance->Shutdown(std::chrono::milliseconds(1000));
+    close(stream_client);
+    close(stream_server);
+    close(dgram_server);
+
+    // while disconnected, the newest records are kept up to buffer_size bytes, then sent on reconnection
+    unlink("./logs/agent_stream.sock");
+    std::shared_ptr<spdlog_json_config::sinks::unix_socket_sink_st> sink =
+        std::make_shared<spdlog_json_config::sinks::unix_socket_sink_st>(
+            "./logs/agent_stream.sock", spdlog_json_config::sinks::unix_socket_type::stream, 4, 100,
+            std::chrono::milliseconds(10), std::chrono::milliseconds(20));
+    spdlog::logger disconnected_logger("DISCONNECTED", sink);
+    disconnected_logger.set_pattern("%v");
+    for(int i = 0; i < 20; i++){
+        disconnected_logger.info("buffered {:02}", i);
+    }
+    REQUIRE(!sink->connected());
+    REQUIRE(sink->drops() == 20 - 100 / strlen("buffered 00\n"));
+
+    stream_server = BindUnixSocket("./logs/agent_stream.sock", SOCK_STREAM);
+    REQUIRE(stream_server >= 0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    disconnected_logger.flush();
+    REQUIRE(sink->connected());
+    stream_client = accept(stream_server, nullptr, nullptr);
+    REQUIRE(stream_client >= 0);
+    content = ReadSocket(stream_client, "buffered 19\n");
+    REQUIRE(content.find("buffered 12\n") == 0);
+    REQUIRE(content.size() == 8 * strlen("buffered 00\n"));
+    close(stream_client);
+    close(stream_server);
+}
+
+
+TEST_CASE("Test sharded file sink and merge", "[SHARDED]"){
+
+    spdlog_json_config::SpdlogJsonConfig* instance = spdlog_json_config::SpdlogJsonConfig::GetInstance();
+    instance->Shutdown(std::chrono::milliseconds(1000));
+    REQUIRE(instance->Initialize("./sharded_logger_config.json") == true);
+
+    // each thread writes its own file
+    const int THREAD_NUM = 4;
+    const int MESSAGE_NUM = 1000;
+    std::shared_ptr<spdlog::logger> logger = instance->GetLogger("SHARDED");
+    std::vector<std::thread> threads;
+    std::vector<size_t> thread_ids(THREAD_NUM);
+    for(int t = 0; t < THREAD_NUM; t++){
+        threads.emplace_back([&logger, &thread_ids, t, MESSAGE_NUM](){
+            thread_ids[t] = spdlog::details::os::thread_id();
+            for(int i = 0; i < MESSAGE_NUM; i++){
+                logger->info("thread {} message {}", t, i);
+            }
+        });
+    }
+    for(auto& thread : threads){
+        thread.join();
+    }
+    logger->flush();
+
+    std::vector<std::string> filenames;
+    for(int t = 0; t < THREAD_NUM; t++){
+        filenames.push_back("./logs/sharded-" + std::to_string(thread_ids[t]) + ".log");
+        std::string content = ReadLogFile(filenames.back());
+        REQUIRE(content.find("thread " + std::to_string(t) + " message " + std::to_string(MESSAGE_NUM - 1) + "\n")
+                != std::string::npos);
+        REQUIRE(content.find("thread " + std::to_string((t + 1) % THREAD_NUM) + " ") == std::string::npos);
+    }
+
+    // the merged file has all the records ordered by timestamp, and each thread in order
+    FILE* out = fopen("./logs/sharded_merged.log", "w");
+    REQUIRE(out != nullptr);
+    std::string error;
+    spdlog_json_config::details::shard_merge merger;
+    REQUIRE(merger.merge(filenames, out, error));
+    fclose(out);
+
+    std::ifstream merged("./logs/sharded_merged.log");
+    std::string line;
+    std::string last_key;
+    std::vector<int> next_message(THREAD_NUM, 0);
+    int line_count = 0;
+    while(std::getline(merged, line)){
+        std::string key = line.substr(0, line.find(']') + 1);
+        REQUIRE(key >= last_key);
+        last_key = key;
+        int t, i;
+        REQUIRE(sscanf(line.c_str() + line.find(" thread "), " thread %d message %d", &t, &i) == 2);
+        REQUIRE(i == next_message[t]);
+        next_message[t]++;
+        line_count++;
+    }
+    REQUIRE(line_count == THREAD_NUM * MESSAGE_NUM);
+}
+
+
+TEST_CASE("Test rate limit of sinks and loggers", "[RATE_LIMIT]"){
+
+    // the bucket accepts a burst, then one token per interval
+    spdlog_json_config::details::token_bucket bucket(10, 5);
+    for(int i = 0; i < 5; i++){
+        REQUIRE(bucket.take(0, 1));
+    }
+    REQUIRE(!bucket.take(0, 1));
+    REQUIRE(bucket.take(100000000, 1));
+    REQUIRE(!bucket.take(100000000, 1));
+
+    spdlog_json_config::SpdlogJsonConfig* instance = spdlog_json_config::SpdlogJsonConfig::GetInstance();
+    instance->Shutdown(std::chrono::milliseconds(1000));
+    REQUIRE(instance->Initialize("./rate_limit_logger_config.json") == true);
+
+    // a burst of records to a limited sink
+    const int MESSAGE_NUM = 1000;
+    std::shared_ptr<spdlog::logger> sink_logger = instance->GetLogger("RATE_LIMIT_SINK");
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for(int i = 0; i < MESSAGE_NUM; i++){
+        sink_logger->info("limited message {}", i);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    sink_logger->flush();
+    std::string content = ReadLogFile("./logs/rate_limit_sink.log");
+    int written = 0;
+    for(size_t pos = content.find("limited message"); pos != std::string::npos; pos = content.find("limited message", pos + 1)){
+        written++;
+    }
+    // "Logger started" took one token
+    REQUIRE(written >= 19);
+    REQUIRE(written <= 19 + static_cast<int>(seconds * 10) + 1);
+
+    // the summary comes with the next record accepted
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    sink_logger->info("after the burst");
+    content = ReadLogFile("./logs/rate_limit_sink.log");
+    std::string summary = "rate limit: " + std::to_string(MESSAGE_NUM - written) + " messages";
+    REQUIRE(content.find(summary) != std::string::npos);
+    REQUIRE(content.find(summary) < content.find("after the burst"));
+
+    // a logger limited by bytes, the summary is written on flush
+    std::shared_ptr<spdlog::logger> logger = instance->GetLogger("RATE_LIMIT_LOGGER");
+    std::string payload(100, 'x');
+    for(int i = 0; i < MESSAGE_NUM; i++){
+        logger->info("{}", payload);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    logger->flush();
+    content = ReadLogFile("./logs/rate_limit_logger.log");
+    written = 0;
+    for(size_t pos = content.find(payload); pos != std::string::npos; pos = content.find(payload, pos + 1)){
+        written++;
+    }
+    REQUIRE(written >= 9);
+    REQUIRE(written < 20);
+    // a slow loop, e.g. under a sanitizer, writes a summary every interval
+    int suppressed = 0;
+    for(size_t pos = content.find("rate limit: "); pos != std::string::npos; pos = content.find("rate limit: ", pos + 1)){
+        suppressed += atoi(content.c_str() + pos + strlen("rate limit: "));
+    }
+    REQUIRE(suppressed == MESSAGE_NUM - written);
+}
+
+
+TEST_CASE("Test duplicate records collapsed", "[DEDUP]"){
+
+    spdlog_json_config::SpdlogJsonConfig* instance = spdlog_json_config::SpdlogJsonConfig::GetInstance();
+    instance->Shutdown(std::chrono::milliseconds(1000));
+    REQUIRE(instance->Initialize("./dedup_logger_config.json") == true);
+
+    // the repeats are counted before the next different record
+    std::shared_ptr<spdlog::logger> logger = instance->GetLogger("DEDUP");
+    for(int i = 0; i < 1000; i++){
+        logger->error("connection refused");
+    }
+    logger->warn("connection refused");
+    logger->flush();
+    std::string content = ReadLogFile("./logs/dedup.log");
+    size_t first = content.find("[E] connection refused\n");
+    REQUIRE(first != std::string::npos);
+    REQUIRE(content.find("[E] connection refused\n", first + 1) == std::string::npos);
+    size_t repeated = content.find("[E] last message repeated 999 times\n");
+    REQUIRE(repeated > first);
+    REQUIRE(content.find("[W] connection refused\n") > repeated);
+
+    // the repeats are written on flush after the window, then the record is written again
+    logger->warn("connection refused");
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    logger->flush();
+    content = ReadLogFile("./logs/dedup.log");
+    REQUIRE(content.find("[W] last message repeated 1 times\n") != std::string::npos);
+    logger->warn("connection refused");
+    logger->flush();
+    content = ReadLogFile("./logs/dedup.log");
+    size_t last = content.rfind("[W] connection refused\n");
+    REQUIRE(last > content.find("[W] last message repeated 1 times\n"));
+}
+
+
+TEST_CASE("Test records formatted once for sinks of the same pattern", "[FORMAT_ONCE]"){
+
+    spdlog_json_config::SpdlogJsonConfig* instance = spdlog_json_config::SpdlogJsonConfig::GetInstance();
+    instance->Shutdown(std::chrono::milliseconds(1000));
+    REQUIRE(instance->Initialize("./format_once_logger_config.json") == true);
+
+    // the file sinks are grouped, the color sink formats for itself
+    std::shared_ptr<spdlog::logger> logger = instance->GetLogger("FORMAT_ONCE");
+    REQUIRE(logger->sinks().size() == 2);
+    std::shared_ptr<spdlog_json_config::sinks::format_group_sink> group =
+        std::dynamic_pointer_cast<spdlog_json_config::sinks::format_group_sink>(logger->sinks()[1]);
+    REQUIRE(group != nullptr);
+    REQUIRE(group->sinks().size() == 2);
+
+    // each sink writes the same formatted text, at its own level
+    logger->info("format once info");
+    logger->warn("format once warn");
+    logger->flush();
+    std::string content = ReadLogFile("./logs/format_once.log");
+    std::string rotate_content = ReadLogFile("./logs/format_once_rotate.log");
+    REQUIRE(content.find("[FORMAT_ONCE][I] format once info\n") != std::string::npos);
+    REQUIRE(rotate_content.find("format once info") == std::string::npos);
+    size_t start = content.find("[FORMAT_ONCE][W] format once warn\n");
+    REQUIRE(start != std::string::npos);
+    start = content.rfind('\n', start) + 1;
+    std::string line = content.substr(start, content.find('\n', start) + 1 - start);
+    // the rotating file is not truncated, compare its last record
+    REQUIRE(rotate_content.size() >= line.size());
+    REQUIRE(rotate_content.compare(rotate_content.size() - line.size(), line.size(), line) == 0);
+
+    // a shared sink gets the records of another logger formatted with its pattern
+    std::shared_ptr<spdlog::logger> short_logger = instance->GetLogger("FORMAT_ONCE_SHORT");
+    short_logger->info("format once short");
+    short_logger->flush();
+    for(int i = 0; i < 100 && content.find("<FORMAT_ONCE_SHORT> format once short\n") == std::string::npos; i++){
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        content = ReadLogFile("./logs/format_once.log");
+    }
+    REQUIRE(content.find("<FORMAT_ONCE_SHORT> format once short\n") != std::string::npos);
+
+    // the pattern set on the logger applies to the group
+    logger->set_pattern("{%n} %v");
+    logger->error("format once pattern");
+    logger->flush();
+    REQUIRE(ReadLogFile("./logs/format_once_rotate.log").find("{FORMAT_ONCE} format once pattern\n") != std::string::npos);
+}
+
+
+TEST_CASE("Test sink patterns win over logger patterns", "[PATTERN]"){
+
+    spdlog_json_config::SpdlogJsonConfig* instance = spdlog_json_config::SpdlogJsonConfig::GetInstance();
+    instance->Shutdown(std::chrono::milliseconds(1000));
+    REQUIRE(instance->Initialize("./pattern_logger_config.json") == true);
+
+    // the raw sinks are grouped on their own pattern, the rich file sink is alone on the logger pattern
+    std::shared_ptr<spdlog::logger> logger = instance->GetLogger("PATTERN");
+    REQUIRE(logger->sinks().size() == 3);
+    std::shared_ptr<spdlog_json_config::sinks::format_group_sink> group =
+        std::dynamic_pointer_cast<spdlog_json_config::sinks::format_group_sink>(logger->sinks()[1]);
+    REQUIRE(group != nullptr);
+    REQUIRE(group->sinks().size() == 2);
+
+    logger->info("pattern message");
+    instance->GetLogger("PATTERN_RAW")->warn("pattern raw message");
+    logger->flush();
+    instance->GetLogger("PATTERN_RAW")->flush();
+    REQUIRE(ReadLogFile("./logs/pattern_raw.log") == "Logger started\nLogger started\npattern message\npattern raw message\n");
+    REQUIRE(ReadLogFile("./logs/pattern_raw_copy.log") == "Logger started\npattern message\n");
+    std::string rich = ReadLogFile("./logs/pattern_rich.log");
+    REQUIRE(rich.find("[PATTERN][I] pattern message\n") != std::string::npos);
+}
+
+
+TEST_CASE("Test sinks of the same file share one sink", "[SHARED_SINK]"){
+
+    spdlog_json_config::SpdlogJsonConfig* instance = spdlog_json_config::SpdlogJsonConfig::GetInstance();
+    instance->Shutdown(std::chrono::milliseconds(1000));
+    REQUIRE(instance->Initialize("./shared_sink_logger_config.json") == true);
+
+    // one file sink behind the two sinks, each with its level
+    std::shared_ptr<spdlog::logger> info_logger = instance->GetLogger("SHARED_INFO");
+    std::shared_ptr<spdlog::logger> error_logger = instance->GetLogger("SHARED_ERROR");
+    std::shared_ptr<spdlog_json_config::sinks::proxy_sink> info_sink =
+        std::dynamic_pointer_cast<spdlog_json_config::sinks::proxy_sink>(info_logger->sinks()[0]);
+    std::shared_ptr<spdlog_json_config::sinks::proxy_sink> error_sink =
+        std::dynamic_pointer_cast<spdlog_json_config::sinks::proxy_sink>(error_logger->sinks()[0]);
+    REQUIRE(info_sink != nullptr);
+    REQUIRE(error_sink != nullptr);
+    REQUIRE(info_sink->wrapped_sink() == error_sink->wrapped_sink());
+    REQUIRE(info_sink->level() == spdlog::level::info);
+    REQUIRE(error_sink->level() == spdlog::level::err);
+
+    // the records of both loggers are whole lines of one file
+    const int MESSAGE_NUM = 1000;
+    std::thread producer([error_logger, MESSAGE_NUM](){
+        for(int i = 0; i < MESSAGE_NUM; i++){
+            error_logger->error("shared error {}", i);
+            error_logger->warn("shared warn {}", i);
+        }
+    });
+    for(int i = 0; i < MESSAGE_NUM; i++){
+        info_logger->info("shared info {}", i);
+    }
+    producer.join();
+    info_logger->flush();
+    error_logger->flush();
+    std::string last = "[SHARED_ERROR][E] shared error " + std::to_string(MESSAGE_NUM - 1) + "\n";
+    std::string content = WaitLogFile("./logs/shared.log", last);
+    REQUIRE(content.find("shared warn") == std::string::npos);
+    REQUIRE(content.find("[SHARED_INFO][I] shared info " + std::to_string(MESSAGE_NUM - 1) + "\n") != std::string::npos);
+    size_t lines = 0;
+    for(size_t pos = content.find('\n'); pos != std::string::npos; pos = content.find('\n', pos + 1)){
+        lines++;
+    }
+    REQUIRE(lines == 2 * MESSAGE_NUM + 1);
+
+    // sinks of the same file differing by more than the level are rejected
+    instance->Shutdown(std::chrono::milliseconds(1000));
+    FILE* file = fopen("./logs/shared_conflict_config.json", "w");
+    REQUIRE(file != nullptr);
+    fputs("{\"SINKS\": {"
+          "\"conflict_a\": {\"type\": \"basic_file_sink_mt\", \"file_name\": \"./logs/conflict.log\", \"truncate\": true},"
+          "\"conflict_b\": {\"type\": \"basic_file_sink_mt\", \"file_name\": \"./logs/conflict.log\"}},"
+          "\"LOGGERS\": {\"CONFLICT\": {\"sinks\": [\"conflict_a\", \"conflict_b\"], \"sync_type\": \"sync\"}}}", file);
+    fclose(file);
+    REQUIRE(instance->Initialize("./logs/shared_conflict_config.json") == false);
+}
+
+
+TEST_CASE("Test sink types registered by the application", "[CUSTOM_SINK]"){
+
+    spdlog_json_config::SpdlogJsonConfig* instance = spdlog_json_config::SpdlogJsonConfig::GetInstance();
+    instance->Shutdown(std::chrono::milliseconds(1000));
+
+    // the factory gets the configuration object of the sink
+    std::shared_ptr<spdlog::sinks::ringbuffer_sink_mt> memory_sink;
+    spdlog_json_config::SpdlogJsonConfig::SinkFactory factory =
+        [&memory_sink](const std::string& sink_name, const std::string& sink_type, const rapidjson::Value& value){
+            rapidjson::Value::ConstMemberIterator it = value.FindMember("capacity");
+            if(it == value.MemberEnd()){
+                return std::shared_ptr<spdlog::sinks::sink>();
+            }
+            memory_sink = std::make_shared<spdlog::sinks::ringbuffer_sink_mt>(it->value.GetUint());
+            return std::static_pointer_cast<spdlog::sinks::sink>(memory_sink);
+        };
+    REQUIRE(instance->RegisterSinkType("memory_sink_mt", factory) == true);
+    REQUIRE(instance->RegisterSinkType("memory_sink_mt", factory) == false);
+    REQUIRE(instance->RegisterSinkType("basic_file_sink_mt", factory) == false);
+    REQUIRE(instance->Initialize("./custom_sink_logger_config.json") == true);
+    REQUIRE(memory_sink != nullptr);
+
+    // the level and pattern of the configuration apply to the sink
+    std::shared_ptr<spdlog::logger> logger = instance->GetLogger("CUSTOM");
+    logger->debug("custom debug");
+    for(int i = 0; i < 20; i++){
+        logger->info("custom info {}", i);
+    }
+    std::vector<std::string> lines = memory_sink->last_formatted();
+    REQUIRE(lines.size() == 16);
+    REQUIRE(lines.back() == "[I] custom info 19\n");
+    REQUIRE(lines.front() == "[I] custom info 4\n");
+
+    // a sink the factory fails to create fails the initialization
+    instance->Shutdown(std::chrono::milliseconds(1000));
+    mkdir("./logs", 0755);
+    FILE* file = fopen("./logs/custom_failure_config.json", "w");
+    REQUIRE(file != nullptr);
+    fputs("{\"SINKS\": {\"no_capacity\": {\"type\": \"memory_sink_mt\"}},"
+          "\"LOGGERS\": {\"CUSTOM_FAILURE\": {\"sinks\": [\"no_capacity\"], \"sync_type\": \"sync\"}}}", file);
+    fclose(file);
+    REQUIRE(instance->Initialize("./logs/custom_failure_config.json") == false);
+}
+
+TEST_CASE("Test sink types registered by a plugin", "[PLUGIN]"){
+
+    spdlog_json_config::SpdlogJsonConfig* instance = spdlog_json_config::SpdlogJsonConfig::GetInstance();
+    instance->Shutdown(std::chrono::milliseconds(1000));
+
+    mkdir("./logs", 0755);
+    remove("./logs/plugin.log");
+    REQUIRE(instance->Initialize("./plugin_logger_config.json") == true);
+
+    std::shared_ptr<spdlog::logger> logger = instance->GetLogger("PLUGIN");
+    logger->debug("plugin debug");
+    logger->info("plugin info");
+    logger->flush();
+
+    REQUIRE(ReadLogFile("./logs/plugin.log") == "[I] Logger started\n[I] plugin info\n");
+
+    // a missing plugin fails the initialization
+    instance->Shutdown(std::chrono::milliseconds(1000));
+    FILE* file = fopen("./logs/plugin_failure_config.json", "w");
+    REQUIRE(file != nullptr);
+    fputs("{\"PLUGINS\": [\"./libmissing_plugin.so\"],"
+          "\"LOGGERS\": {\"PLUGIN_FAILURE\": {\"sinks\": [], \"sync_type\": \"sync\"}}}", file);
+    fclose(file);
+    REQUIRE(instance->Initialize("./logs/plugin_failure_config.json") == false);
+}
+
+
+TEST_CASE("Test runtime control over the admin socket", "[ADMIN_SOCKET]"){
+
+    spdlog_json_config::SpdlogJsonConfig* instance = spdlog_json_config::SpdlogJsonConfig::GetInstance();
+    instance->Shutdown(std::chrono::milliseconds(1000));
+
+    mkdir("./logs", 0755);
+    remove("./logs/admin.log");
+    remove("./logs/admin.log.1");
+    remove("./logs/admin_backtrace.log");
+    REQUIRE(instance->Initialize("./admin_logger_config.json") == true);
+    const std::string socket_path("./logs/admin.sock");
+
+    std::string reply = AdminCommand(socket_path, "list");
+    REQUIRE(reply.find(" ADMIN info\n") != std::string::npos);
+    REQUIRE(reply.find(" ADMIN_BACKTRACE warning\n") != std::string::npos);
+    REQUIRE(reply.substr(reply.size() - 3) == "OK\n");
+    REQUIRE(AdminCommand(socket_path, "bogus").find("ERROR unknown command") == 0);
+
+    // turn on debug for one logger
+    std::shared_ptr<spdlog::logger> logger = instance->GetLogger("ADMIN");
+    logger->debug("admin debug before");
+    REQUIRE(AdminCommand(socket_path, "level ADMIN debug") == "OK\n");
+    REQUIRE(AdminCommand(socket_path, "level ADMIN loud").find("ERROR unknown level") == 0);
+    REQUIRE(AdminCommand(socket_path, "level NO_LOGGER debug").find("ERROR logger") == 0);
+    logger->debug("admin debug after");
+    REQUIRE(AdminCommand(socket_path, "flush ADMIN") == "OK\n");
+    REQUIRE(ReadLogFile("./logs/admin.log") == "[I] Logger started\n[D] admin debug after\n");
+
+    // the sink level applies below the logger level
+    REQUIRE(AdminCommand(socket_path, "sink_level admin_sink warn") == "OK\n");
+    REQUIRE(AdminCommand(socket_path, "sinks").find("admin_sink warning\n") != std::string::npos);
+    logger->info("admin info dropped");
+    REQUIRE(AdminCommand(socket_path, "sink_level admin_sink trace") == "OK\n");
+
+    // reopen the file moved by logrotate
+    REQUIRE(rename("./logs/admin.log", "./logs/admin.log.1") == 0);
+    REQUIRE(AdminCommand(socket_path, "reopen") == "reopened 2\nOK\n");
+    REQUIRE(AdminCommand(socket_path, "reopen admin_sink") == "reopened 1\nOK\n");
+    logger->info("admin info reopened");
+    logger->flush();
+    REQUIRE(ReadLogFile("./logs/admin.log") == "[I] admin info reopened\n");
+    REQUIRE(ReadLogFile("./logs/admin.log.1") == "[I] Logger started\n[D] admin debug after\n");
+
+    // dump the backtrace of a logger, and lower its level
+    std::shared_ptr<spdlog::logger> backtrace_logger = instance->GetLogger("ADMIN_BACKTRACE");
+    backtrace_logger->info("backtrace info");
+    REQUIRE(AdminCommand(socket_path, "dump ADMIN") == "ERROR logger 'ADMIN' has no backtrace\n");
+    REQUIRE(AdminCommand(socket_path, "dump ADMIN_BACKTRACE") == "OK\n");
+    REQUIRE(AdminCommand(socket_path, "level ADMIN_BACKTRACE info") == "OK\n");
+    backtrace_logger->info("backtrace info written");
+    backtrace_logger->flush();
+    REQUIRE(ReadLogFile("./logs/admin_backtrace.log") ==
+            "[I] Logger started\n[I] backtrace info\n[I] backtrace info written\n");
+
+    REQUIRE(AdminCommand(socket_path, "stats").find("pending 0\n") == 0);
+
+    // the socket is removed on shutdown
+    instance->Shutdown(std::chrono::milliseconds(1000));
+    REQUIRE(access(socket_path.c_str(), F_OK) != 0);
+}
+
+
+TEST_CASE("Test levels changed in the level control file", "[LEVEL_CONTROL]"){
+
+    spdlog_json_config::SpdlogJsonConfig* instance = spdlog_json_config::SpdlogJsonConfig::GetInstance();
+    instance->Shutdown(std::chrono::milliseconds(1000));
+
+    mkdir("./logs", 0755);
+    REQUIRE(instance->Initialize("./level_control_logger_config.json") == true);
+    uint32_t logger_id = 0;
+    uint32_t backtrace_logger_id = 0;
+    REQUIRE(instance->GetLoggerId("LEVEL_CONTROL", logger_id) == true);
+    REQUIRE(instance->GetLoggerId("LEVEL_CONTROL_BACKTRACE", backtrace_logger_id) == true);
+
+    // the levels of the loggers are published by id
+    spdlog_json_config::details::level_control::block levels;
+    std::string error;
+    REQUIRE(levels.open("./logs/test.loglevels", error) == true);
+    REQUIRE(levels.pid() == static_cast<uint32_t>(getpid()));
+    REQUIRE(levels.name(logger_id) == "LEVEL_CONTROL");
+    REQUIRE(levels.level(logger_id) == spdlog::level::info);
+    REQUIRE(levels.name(backtrace_logger_id) == "LEVEL_CONTROL_BACKTRACE");
+    REQUIRE(levels.level(backtrace_logger_id) == spdlog::level::warn);
+
+    // a level written by another process applies on the next GetLogger(id)
+    instance->GetLogger(logger_id)->debug("control debug before");
+    levels.set_level(logger_id, spdlog::level::debug);
+    instance->GetLogger(logger_id)->debug("control debug after");
+    REQUIRE(instance->GetLogger("LEVEL_CONTROL")->level() == spdlog::level::debug);
+
+    // the level of a logger with a backtrace is the level of its backtrace sink
+    levels.set_level(backtrace_logger_id, spdlog::level::info);
+    instance->GetLogger(backtrace_logger_id)->info("control backtrace info");
+    REQUIRE(instance->GetLogger(backtrace_logger_id)->level() == spdlog::level::trace);
+
+    // an id not given to a logger is not looked up in the level control file
+    REQUIRE(instance->GetLogger(spdlog_json_config::SpdlogJsonConfig::MAX_LOGGER_NUM + 5) == nullptr);
+    REQUIRE(instance->GetDeferredLogger(spdlog_json_config::SpdlogJsonConfig::MAX_LOGGER_NUM + 5) == nullptr);
+
+    // a level out of range is ignored
+    levels.set_level(logger_id, 42);
+    instance->GetLogger(logger_id)->debug("control debug out of range");
+    instance->GetLogger(logger_id)->flush();
+    REQUIRE(ReadLogFile("./logs/level_control.log") ==
+            "[I] Logger started\n[D] control debug after\n[I] control backtrace info\n[D] control debug out of range\n");
+
+    // the file is removed on shutdown
+    instance->Shutdown(std::chrono::milliseconds(1000));
+    REQUIRE(access("./logs/test.loglevels", F_OK) != 0);
+
+    // a block creating another file maps it in place of the previous one
+    spdlog_json_config::details::level_control::block owner;
+    spdlog_json_config::details::level_control::block first;
+    REQUIRE(owner.create("./logs/first.loglevels", 4, error) == true);
+    REQUIRE(first.open("./logs/first.loglevels", error) == true);
+    REQUIRE(owner.create("./logs/second.loglevels", 4, error) == true);
+    owner.set_level(1, spdlog::level::err);
+    REQUIRE(first.level(1) == spdlog::level::off);
+    spdlog_json_config::details::level_control::block second;
+    REQUIRE(second.open("./logs/second.loglevels", error) == true);
+    REQUIRE(second.level(1) == spdlog::level::err);
+    REQUIRE(owner.create("./logs/third.loglevels", 8, error) == false);
+    std::remove("./logs/first.loglevels");
+    std::remove("./logs/second.loglevels");
+}
@@ -0,0 +1,96 @@
+/**
+ * Render the files of a binary_file_sink as text, with a pattern of a configuration file.
+ *
+ * Usage: binary_log_decoder <config.json> <pattern_name> <binary_file>...
+ *
+ * The pattern is looked up in the PATTERNS section of the configuration, e.g.:
+ *
+ *      ./binary_log_decoder ../example/config_logger/logger_config.json general_pattern ./logs/binary.log
+ */
+#include <stdio.h>
+#include <string>
+
+#include "rapidjson/document.h"
+#include "rapidjson/error/en.h"
+
+#include "spdlog/pattern_formatter.h"
+
+#include "details/binary_record.h"
+
+
+static bool read_pattern(const char* config_file, const char* pattern_name, std::string& pattern){
+    FILE* file = fopen(config_file, "r");
+    if(file == nullptr){
+        fprintf(stderr, "Open config file '%s' failure\n", config_file);
+        return false;
+    }
+    std::string content;
+    char buffer[65536];
+    size_t size;
+    while((size = fread(buffer, 1, sizeof(buffer), file)) > 0){
+        content.append(buffer, size);
+    }
+    fclose(file);
+
+    rapidjson::Document doc;
+    doc.Parse<rapidjson::kParseCommentsFlag>(content.c_str());
+    if(doc.HasParseError()){
+        fprintf(stderr, "Parse config file '%s' failure: %s (%lu)\n", config_file,
+                rapidjson::GetParseError_En(doc.GetParseError()), doc.GetErrorOffset());
+        return false;
+    }
+
+    rapidjson::Value::ConstMemberIterator patterns = doc.FindMember("PATTERNS");
+    if(patterns == doc.MemberEnd() || !patterns->value.IsObject() || !patterns->value.HasMember(pattern_name)){
+        fprintf(stderr, "No pattern '%s' in config file '%s'\n", pattern_name, config_file);
+        return false;
+    }
+    const rapidjson::Value& value = patterns->value[pattern_name];
+    if(!value.IsString()){
+        fprintf(stderr, "Pattern '%s' in config file '%s' is not a string\n", pattern_name, config_file);
+        return false;
+    }
+    pattern = value.GetString();
+    return true;
+}
+
+
+int main(int argc, char* argv[]){
+    if(argc < 4){
+        fprintf(stderr, "Usage: %s <config.json> <pattern_name> <binary_file>...\n", argv[0]);
+        return 1;
+    }
+
+    std::string pattern;
+    if(!read_pattern(argv[1], argv[2], pattern)){
+        return 1;
+    }
+    spdlog::pattern_formatter formatter(pattern);
+
+    int ret = 0;
+    for(int i = 3; i < argc; i++){
+        FILE* file = fopen(argv[i], "rb");
+        if(file == nullptr){
+            fprintf(stderr, "Open binary file '%s' failure\n", argv[i]);
+            ret = 1;
+            continue;
+        }
+
+        spdlog_json_config::details::binary_record_reader reader(file);
+        if(!reader.read_header()){
+            fprintf(stderr, "'%s' is not a binary log file\n", argv[i]);
+            ret = 1;
+        }
+        else {
+            spdlog::details::log_msg msg;
+            spdlog::memory_buf_t formatted;
+            while(reader.next(msg)){
+                formatted.clear();
+                formatter.format(msg, formatted);
+                fwrite(formatted.data(), 1, formatted.size(), stdout);
+            }
+        }
+        fclose(file);
+    }
+    return ret;
+}
@@ -0,0 +1,38 @@
+/**
+ * Print the records recovered from the file of a flight_recorder_sink, oldest first.
+ *
+ * Usage: flight_recorder_dump <file> [max_mb]
+ *
+ * max_mb limits the output to the newest records, e.g. after a crash:
+ *
+ *      ./flight_recorder_dump /dev/shm/spdlog_flight_recorder 8
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+#include "details/flight_recorder.h"
+
+
+int main(int argc, char* argv[]){
+    if(argc < 2 || argc > 3){
+        fprintf(stderr, "Usage: %s <file> [max_mb]\n", argv[0]);
+        return 1;
+    }
+    size_t max_bytes = 0;
+    if(argc == 3){
+        max_bytes = static_cast<size_t>(strtoull(argv[2], nullptr, 10)) * 1024 * 1024;
+    }
+
+    std::vector<spdlog_json_config::details::flight_recorder::record> records;
+    std::string error;
+    if(!spdlog_json_config::details::flight_recorder::read(argv[1], max_bytes, records, error)){
+        fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    for(size_t i = 0; i < records.size(); i++){
+        fwrite(records[i].text.data(), 1, records[i].text.size(), stdout);
+    }
+    return 0;
+}
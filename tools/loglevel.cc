@@ -0,0 +1,90 @@
+/**
+ * List or change the levels of the loggers of processes, in their level control files.
+ *
+ * Usage: loglevel <file>...
+ *        loglevel -s <logger name or id> <level> <file>...
+ *
+ * The levels are changed in place, the processes apply them on their next GetLogger(id):
+ *
+ *      ./loglevel -s PARSER debug /dev/shm/parser.*.loglevels
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+#include "details/level_control.h"
+
+namespace level_control = spdlog_json_config::details::level_control;
+
+
+static void PrintLevels(const std::string& path, const level_control::block& levels){
+    printf("%s (pid %u)\n", path.c_str(), levels.pid());
+    for(uint32_t id = 0; id < levels.slot_count(); id++){
+        std::string name = levels.name(id);
+        if(name.empty()){
+            continue;
+        }
+        int32_t level = levels.level(id);
+        printf("  %u %s %s\n", id, name.c_str(),
+               (level >= 0 && level < level_control::LEVEL_COUNT) ? level_control::LEVEL_NAMES[level] : "?");
+    }
+}
+
+/// Find a logger by name, or by id
+static bool FindLogger(const level_control::block& levels, const std::string& logger, uint32_t& id){
+    for(id = 0; id < levels.slot_count(); id++){
+        if(levels.name(id) == logger){
+            return true;
+        }
+    }
+    char* end = nullptr;
+    unsigned long logger_id = strtoul(logger.c_str(), &end, 10);
+    if(logger.empty() || *end != '\0' || logger_id >= levels.slot_count() || levels.name(logger_id).empty()){
+        return false;
+    }
+    id = static_cast<uint32_t>(logger_id);
+    return true;
+}
+
+int main(int argc, char* argv[]){
+    bool set = (argc >= 2 && strcmp(argv[1], "-s") == 0);
+    int first_file = set ? 4 : 1;
+    if(argc <= first_file){
+        fprintf(stderr, "Usage: %s <file>...\n"
+                        "       %s -s <logger name or id> <level> <file>...\n", argv[0], argv[0]);
+        return 1;
+    }
+
+    int32_t level = -1;
+    if(set){
+        level = level_control::level_from_name(argv[3]);
+        if(level < 0){
+            fprintf(stderr, "Unknown level %s\n", argv[3]);
+            return 1;
+        }
+    }
+
+    int status = 0;
+    for(int i = first_file; i < argc; i++){
+        level_control::block levels;
+        std::string error;
+        if(!levels.open(argv[i], error)){
+            fprintf(stderr, "%s\n", error.c_str());
+            status = 1;
+            continue;
+        }
+        if(!set){
+            PrintLevels(argv[i], levels);
+            continue;
+        }
+        uint32_t id;
+        if(!FindLogger(levels, argv[2], id)){
+            fprintf(stderr, "%s: logger %s not found\n", argv[i], argv[2]);
+            status = 1;
+            continue;
+        }
+        levels.set_level(id, level);
+    }
+    return status;
+}
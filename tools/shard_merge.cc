@@ -0,0 +1,40 @@
+/**
+ * Merge the shards of a sharded_file_sink into one output ordered by timestamp.
+ *
+ * Usage: shard_merge [-k key_length] <shard_file>...
+ *
+ * The records are compared on their text up to the first ']', or on their first
+ * key_length characters, see details/shard_merge.h. E.g.:
+ *
+ *      ./shard_merge ./logs/app-*.log > app.log
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "details/shard_merge.h"
+
+
+int main(int argc, char* argv[]){
+    size_t key_length = 0;
+    int first = 1;
+    if(argc > 2 && strcmp(argv[1], "-k") == 0){
+        key_length = static_cast<size_t>(strtoull(argv[2], nullptr, 10));
+        first = 3;
+    }
+    if(first >= argc){
+        fprintf(stderr, "Usage: %s [-k key_length] <shard_file>...\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<std::string> filenames(argv + first, argv + argc);
+    std::string error;
+    spdlog_json_config::details::shard_merge merger(key_length);
+    if(!merger.merge(filenames, stdout, error)){
+        fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    return 0;
+}